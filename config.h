@@ -0,0 +1,35 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+#ifdef SPLIT_KEYBOARD
+// Split transaction used to sync OS, layer and indicator state to the slave half
+#    define SPLIT_TRANSACTION_IDS_USER USER_SYNC_STATE
+#endif
+
+#if (defined(OS_ACTION_REMAP_ENABLE) && defined(RAW_ENABLE)) || defined(ADAPTIVE_TERM_ENABLE)
+// User EEPROM datablock: runtime OS action overrides and learned tapping terms
+#    define EECONFIG_USER_DATA_SIZE 48
+#endif
+
+#ifdef ADAPTIVE_TERM_ENABLE
+// Tapping terms are learned per key by the adaptive tapping term in keymap.c
+#    define TAPPING_TERM_PER_KEY
+#endif
+
+#if defined(RGB_IDLE_ENABLE) && defined(RGB_MATRIX_ENABLE)
+// Frame interval is lowered at runtime by the RGB idle tracker in keymap.c;
+// switching the matrix off after a longer idle period is left to QMK
+#    define RGB_MATRIX_LED_FLUSH_LIMIT rgb_idle_frame_ms
+#    ifndef RGB_MATRIX_TIMEOUT
+#        define RGB_MATRIX_TIMEOUT 300000  // 5 minutes
+#    endif
+#    ifdef SPLIT_KEYBOARD
+// The other half times out on this half's keys too
+#        define SPLIT_ACTIVITY_ENABLE
+#    endif
+#    ifndef __ASSEMBLER__
+#        include <stdint.h>
+extern uint16_t rgb_idle_frame_ms;
+#    endif
+#endif
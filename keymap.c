@@ -2,12 +2,22 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 
 #include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
 #include QMK_KEYBOARD_H
 
 #ifdef RGB_MATRIX_ENABLE
     #include "rgb_matrix.h"
 #endif
 
+#if defined(LATENCY_HISTOGRAM_ENABLE) && defined(__AVR__)
+    #include "timer_avr.h"
+#endif
+
+#if !defined(OS_ACTIONS_ENABLE) && (defined(OS_WHEEL_ENABLE) || defined(OS_ACTION_REMAP_ENABLE) || defined(OS_CHORD_ENABLE))
+    #error "OS_WHEEL_ENABLE, OS_ACTION_REMAP_ENABLE and OS_CHORD_ENABLE need OS_ACTIONS_ENABLE"
+#endif
+
 /**
  * ============================================================================
  * OS-AGNOSTIC KEYBOARD SHORTCUTS
@@ -65,11 +75,48 @@
  *                macOS/iOS:   Wheel left
  *                Windows/Linux: Wheel right (reversed)
  *
+ * GO_BACK      - Browser: previous page
+ *                macOS:   Cmd+[
+ *                Windows/Linux: Alt+Left
+ *
+ * GO_FORWARD   - Browser: next page
+ *                macOS:   Cmd+]
+ *                Windows/Linux: Alt+Right
+ *
+ * GO_UPPER     - File manager: parent folder
+ *                macOS:   Cmd+Up
+ *                Windows/Linux: Alt+Up
+ *
+ * GO_LOWER     - File manager: open selected folder
+ *                macOS:   Cmd+Down
+ *                Windows/Linux: Enter
+ *
+ * KC_EMOJI     - Emoji picker
+ *                macOS:   Ctrl+Cmd+Space
+ *                Windows: Win+.
+ *                Linux:   Ctrl+. (GTK emoji chooser)
+ *
+ * TAP_P        - Cycle windows of the current application
+ *                macOS:   Cmd+`
+ *                Windows: Alt+Esc
+ *                Linux:   Alt+`
+ *
+ * LAT_DUMP     - Print the key latency histogram to the console
+ *                (hold Shift to reset it instead)
+ *
+ * LANG_EN      - Switch the input source to English
+ * LANG_KO      - Switch the input source to Korean
+ *                Send LANG_SW only when the tracked state differs
+ *
  * USAGE NOTES:
  * -----------
  * - OS detection happens automatically after USB connection
- * - RGB Matrix provides visual feedback (White=macOS, Blue=Windows, Green=Linux)
- * - If OS not detected, defaults to macOS shortcuts
+ * - The last detected OS is kept in EEPROM and used from the first keystroke
+ *   after plugging in, until detection confirms or corrects it
+ * - RGB indicators show the OS on Esc (White=macOS, Blue=Windows, Green=Linux,
+ *   Yellow=unknown) on top of the running effect, plus the active layer and
+ *   caps lock
+ * - If OS was never detected, defaults to macOS shortcuts
  * - User can manually place these keycodes anywhere in their keymap
  *
  * MIGRATION FROM OLD SHORTCUTS:
@@ -83,228 +130,2101 @@
  * ============================================================================
  */
 
-#define _BASIC 0
-#define _LEFT_UNDER 1
-#define _RIGHT_UNDER 2
-#define _BOTH_UNDER 3
-#define _LEFT_UP 4
+#define _BASIC 0
+#define _LEFT_UNDER 1
+#define _RIGHT_UNDER 2
+#define _BOTH_UNDER 3
+#define _LEFT_UP 4
+
+/**
+ * OS_ACTIONS - Declarative table of every OS-aware keycode
+ *
+ * One line per keycode, columns in os_variant_t order:
+ *   X(keycode, unsure, linux, windows, macos, ios)
+ *
+ * The custom keycode enum, the action index enum and the PROGMEM lookup
+ * table below are all generated from this list, so adding a new OS-aware
+ * action only needs a new line here. The OS_UNSURE column is what is sent
+ * before OS detection completes.
+ */
+#define OS_ACTIONS(X) \
+    /* Screenshots */ \
+    X(SC_FULL,      LSG(KC_3),       KC_PSCR,       G(S(KC_S)), LSG(KC_3),       LSG(KC_3))       \
+    X(SC_AREA,      LSG(KC_4),       S(KC_PSCR),    G(S(KC_S)), LSG(KC_4),       LSG(KC_4))       \
+    X(SC_MENU,      LSG(KC_5),       KC_PSCR,       G(S(KC_S)), LSG(KC_5),       LSG(KC_5))       \
+    X(SC_CLIP_FULL, LSG(LCTL(KC_3)), C(KC_PSCR),    G(S(KC_S)), LSG(LCTL(KC_3)), LSG(LCTL(KC_3))) \
+    X(SC_CLIP_AREA, LSG(LCTL(KC_4)), C(S(KC_PSCR)), G(S(KC_S)), LSG(LCTL(KC_4)), LSG(LCTL(KC_4))) \
+    /* Language switching */ \
+    X(LANG_SW,      LCTL(KC_SPC),    LSFT(KC_SPC),  KC_RALT,    LCTL(KC_SPC),    KC_CAPS)         \
+    OS_WHEEL_ACTIONS(X)
+
+#ifdef OS_WHEEL_ENABLE
+#define OS_WHEEL_ACTIONS(X) \
+    /* Mouse wheel (natural on macOS/iOS, reversed elsewhere) */ \
+    X(MW_RIGHT,     MS_WHLL,         MS_WHLL,       MS_WHLL,    MS_WHLR,         MS_WHLR)         \
+    X(MW_UP,        MS_WHLD,         MS_WHLD,       MS_WHLD,    MS_WHLU,         MS_WHLU)         \
+    X(MW_DOWN,      MS_WHLU,         MS_WHLU,       MS_WHLU,    MS_WHLD,         MS_WHLD)         \
+    X(MW_LEFT,      MS_WHLR,         MS_WHLR,       MS_WHLR,    MS_WHLL,         MS_WHLL)
+#else
+// Without per-OS direction the MW_* keys are the plain mousekey wheel keys
+#define OS_WHEEL_ACTIONS(X)
+#define MW_RIGHT MS_WHLR
+#define MW_UP    MS_WHLU
+#define MW_DOWN  MS_WHLD
+#define MW_LEFT  MS_WHLL
+#endif
+
+/**
+ * OS_MACROS - Declarative table of OS-aware navigation shortcuts
+ *
+ * Like OS_ACTIONS, one shortcut per OS, held for as long as the key is down
+ * so the host repeats it like holding the shortcut would:
+ *   X(keycode, unsure, linux, windows, macos, ios)
+ */
+#define OS_MACROS(X) \
+    /* Browser navigation */ \
+    X(GO_BACK,    G(KC_LBRC),   A(KC_LEFT), A(KC_LEFT), G(KC_LBRC),   G(KC_LBRC))   \
+    X(GO_FORWARD, G(KC_RBRC),   A(KC_RGHT), A(KC_RGHT), G(KC_RBRC),   G(KC_RBRC))   \
+    /* File manager navigation */ \
+    X(GO_UPPER,   G(KC_UP),     A(KC_UP),   A(KC_UP),   G(KC_UP),     G(KC_UP))     \
+    X(GO_LOWER,   G(KC_DOWN),   KC_ENT,     KC_ENT,     G(KC_DOWN),   G(KC_DOWN))   \
+    /* System */ \
+    X(KC_EMOJI,   G(C(KC_SPC)), C(KC_DOT),  G(KC_DOT),  G(C(KC_SPC)), G(C(KC_SPC))) \
+    X(TAP_P,      G(KC_GRV),    A(KC_GRV),  A(KC_ESC),  G(KC_GRV),    G(KC_GRV))
+
+enum custom_keycodes {
+  BASIC = SAFE_RANGE,
+  LEFT_UNDER,
+  RIGHT_UNDER,
+  BOTH_UNDER,
+  LEFT_UP,
+  // OS-aware keycodes (SC_*, LANG_SW, MW_*), generated from OS_ACTIONS
+#define OS_ACTION_KEYCODE(kc, ...) kc,
+  OS_ACTIONS(OS_ACTION_KEYCODE)
+#undef OS_ACTION_KEYCODE
+  // OS-aware macros (browser/file manager navigation), generated from OS_MACROS
+#define OS_MACRO_KEYCODE(kc, ...) kc,
+  OS_MACROS(OS_MACRO_KEYCODE)
+#undef OS_MACRO_KEYCODE
+  LAT_DUMP,     // Dump latency histogram to console (Shift: reset it)
+  LANG_EN,      // Switch input source to English (LANG_SW only if needed)
+  LANG_KO,      // Switch input source to Korean (LANG_SW only if needed)
+};
+
+// Index of each OS-aware keycode in os_action_table
+enum os_action {
+#define OS_ACTION_INDEX(kc, ...) OS_ACTION_##kc,
+  OS_ACTIONS(OS_ACTION_INDEX)
+#undef OS_ACTION_INDEX
+  OS_ACTION_COUNT
+};
+
+// Index of each OS-aware macro in os_macro_table
+enum os_macro {
+#define OS_MACRO_INDEX(kc, ...) OS_MACRO_##kc,
+  OS_MACROS(OS_MACRO_INDEX)
+#undef OS_MACRO_INDEX
+  OS_MACRO_COUNT
+};
+
+#define OS_ACTION_FIRST SC_FULL
+#define OS_MACRO_FIRST  GO_BACK
+#define OS_VARIANT_COUNT (OS_IOS + 1)
+
+// Legacy macOS-specific constants (kept for backward compatibility in keymap)
+const uint16_t KC_AG = OSM(MOD_LALT|MOD_LGUI);
+
+// BACKWARD COMPATIBILITY: Old macOS-specific screenshot shortcuts
+// These aliases map old keycodes to new OS-agnostic custom keycodes
+// User can replace these in keymap with SC_* keycodes directly
+#ifdef LEGACY_ALIASES_ENABLE
+#define KC_SG3  SC_FULL        // Full screen screenshot
+#define KC_SG4  SC_AREA        // Area selection screenshot
+#define KC_SG5  SC_MENU        // Screenshot menu
+#define KC_SGC3 SC_CLIP_FULL   // Full screen to clipboard
+#define KC_SGC4 SC_CLIP_AREA   // Area selection to clipboard
+#endif
+
+// OS detection state; starts from the OS cached in EEPROM (OS_UNSURE, i.e.
+// macOS shortcuts, on a fresh board) until detection confirms or corrects it
+static os_variant_t current_os = OS_UNSURE;
+
+// User EEPROM block
+typedef union {
+  uint32_t raw;
+  struct {
+    uint8_t last_os : 3;  // Last detected os_variant_t, used for warm start
+  };
+} user_config_t;
+
+static user_config_t user_config;
+
+// ============================================================================
+// Event Log
+// ============================================================================
+// Logging cheap enough for hot paths. LOG_EVENT() stores an event id and two
+// integers in a RAM ring; housekeeping writes a few records per scan to the
+// console as short hex lines ("E" id time a b). No format strings end up in
+// flash: tools/event_log.py reads them from LOG_EVENTS below and prints the
+// formatted lines, passing everything else (e.g. LAT dumps) through.
+
+#if defined(EVENT_LOG_ENABLE) && defined(CONSOLE_ENABLE)
+
+// X(id, format): format is a Python format string over a, b and their high
+// and low bytes a_hi, a_lo, b_hi, b_lo; !o prints an os_variant_t name
+#define LOG_EVENTS(X)                                               \
+    X(LOG_DROPPED,     "log: {a} records dropped")                  \
+    X(LOG_KEY_DOWN,    "key down {a:#06x} at row {b_hi} col {b_lo}") \
+    X(LOG_KEY_UP,      "key up   {a:#06x} at row {b_hi} col {b_lo}") \
+    X(LOG_LAYER,       "layers {a:#07b}")                           \
+    X(LOG_OS_DETECTED, "os detected {a!o}, using {b!o}")            \
+    X(LOG_OS_ACTION,   "os action {a} sends {b:#06x}")
+
+#define LOG_EVENT_ID(id, format) id,
+enum log_event { LOG_EVENTS(LOG_EVENT_ID) LOG_EVENT_COUNT };
+#undef LOG_EVENT_ID
+
+#ifndef LOG_RING_SIZE
+    #define LOG_RING_SIZE 16  // power of two
+#endif
+#ifndef LOG_DRAIN_PER_SCAN
+    #define LOG_DRAIN_PER_SCAN 2
+#endif
+
+_Static_assert((LOG_RING_SIZE & (LOG_RING_SIZE - 1)) == 0, "LOG_RING_SIZE must be a power of two");
+
+typedef struct __attribute__((packed)) {
+    uint8_t  id;
+    uint16_t time;
+    uint16_t a;
+    uint16_t b;
+} log_record_t;
+
+static log_record_t log_ring[LOG_RING_SIZE];
+static uint8_t      log_head;  // next slot to write
+static uint8_t      log_tail;  // next slot to send
+static uint16_t     log_dropped;
+
+static void log_event(uint8_t id, uint16_t a, uint16_t b) {
+    if ((uint8_t)(log_head - log_tail) >= LOG_RING_SIZE) {
+        log_dropped++;
+        return;
+    }
+    log_record_t *record = &log_ring[log_head & (LOG_RING_SIZE - 1)];
+    record->id           = id;
+    record->time         = timer_read();
+    record->a            = a;
+    record->b            = b;
+    log_head++;
+}
+
+static void log_send_hex(uint16_t value, uint8_t digits) {
+    while (digits--) {
+        uint8_t nibble = (value >> (digits * 4)) & 0xF;
+        sendchar(nibble < 10 ? '0' + nibble : 'a' + nibble - 10);
+    }
+}
+
+static void log_task(void) {
+    if (log_dropped && (uint8_t)(log_head - log_tail) < LOG_RING_SIZE) {
+        log_event(LOG_DROPPED, log_dropped, 0);
+        log_dropped = 0;
+    }
+
+    for (uint8_t i = 0; i < LOG_DRAIN_PER_SCAN && log_tail != log_head; i++, log_tail++) {
+        const log_record_t *record = &log_ring[log_tail & (LOG_RING_SIZE - 1)];
+        sendchar('E');
+        log_send_hex(record->id, 2);
+        log_send_hex(record->time, 4);
+        log_send_hex(record->a, 4);
+        log_send_hex(record->b, 4);
+        sendchar('\n');
+    }
+}
+
+    #define LOG_EVENT(id, a, b) log_event(id, a, b)
+#else
+    #define LOG_EVENT(id, a, b) ((void)0)
+#endif // EVENT_LOG_ENABLE && CONSOLE_ENABLE
+
+// ============================================================================
+// Kinetic Mouse Wheel
+// ============================================================================
+// MW_* keys drive a wheel engine instead of the stock mousekey wheel repeat.
+// Each axis keeps a fixed-point speed (1/256 detent per tick) that starts
+// low, accelerates while held and decays after release, and a remainder that
+// collects the fractional detents between reports. The curve is picked from
+// current_os: macOS adds its own acceleration to wheel events, so it gets a
+// gentler curve than Windows/Linux.
+//
+// The mousekey report descriptor has no resolution multiplier, so the host
+// still receives whole detents; the engine only spaces them smoothly.
+
+#ifdef KINETIC_WHEEL_ENABLE
+
+#ifndef WHEEL_TICK_MS
+    #define WHEEL_TICK_MS 10
+#endif
+#ifndef WHEEL_STOP_SPEED
+    #define WHEEL_STOP_SPEED 8  // inertia ends below this speed
+#endif
+
+typedef struct {
+    uint16_t start;  // speed on press
+    uint16_t accel;  // added every tick while held
+    uint16_t max;    // speed limit
+    uint8_t  decay;  // after release: speed -= speed >> decay every tick
+} wheel_curve_t;
+
+static const wheel_curve_t PROGMEM wheel_curves[OS_VARIANT_COUNT] = {
+    [OS_UNSURE]  = { .start = 20, .accel = 2, .max = 96, .decay = 3 },
+    [OS_LINUX]   = { .start = 24, .accel = 2, .max = 96, .decay = 3 },
+    [OS_WINDOWS] = { .start = 24, .accel = 2, .max = 96, .decay = 3 },
+    [OS_MACOS]   = { .start = 16, .accel = 1, .max = 64, .decay = 2 },
+    [OS_IOS]     = { .start = 16, .accel = 1, .max = 64, .decay = 2 },
+};
+
+enum wheel_axis_index { WHEEL_AXIS_V, WHEEL_AXIS_H, WHEEL_AXIS_COUNT };
+
+typedef struct {
+    uint16_t speed;
+    int16_t  remainder;
+    int8_t   dir;   // +1 up/right, -1 down/left
+    bool     held;
+} wheel_axis_t;
+
+static wheel_axis_t wheel_axes[WHEEL_AXIS_COUNT];
+static uint16_t     wheel_timer;
+static bool         wheel_active;
+
+static const wheel_curve_t *wheel_curve_for(os_variant_t os, wheel_curve_t *curve) {
+    memcpy_P(curve, &wheel_curves[(os < OS_VARIANT_COUNT) ? os : OS_UNSURE], sizeof(*curve));
+    return curve;
+}
+
+/**
+ * wheel_key - Feed a resolved MS_WHL* keycode to the wheel engine
+ * Returns false for keycodes that are not wheel keys.
+ */
+static bool wheel_key(uint16_t keycode, bool pressed) {
+    uint8_t axis;
+    int8_t  dir;
+
+    switch (keycode) {
+        case MS_WHLU: axis = WHEEL_AXIS_V; dir = 1;  break;
+        case MS_WHLD: axis = WHEEL_AXIS_V; dir = -1; break;
+        case MS_WHLR: axis = WHEEL_AXIS_H; dir = 1;  break;
+        case MS_WHLL: axis = WHEEL_AXIS_H; dir = -1; break;
+        default:
+            return false;
+    }
+
+    wheel_axis_t *w = &wheel_axes[axis];
+    if (pressed) {
+        wheel_curve_t curve;
+        w->speed = wheel_curve_for(current_os, &curve)->start;
+        w->dir   = dir;
+        w->held  = true;
+
+        // First detent goes out on the next tick instead of after a full ramp
+        w->remainder = dir * 255;
+        if (!wheel_active) {
+            wheel_active = true;
+            wheel_timer  = timer_read() - WHEEL_TICK_MS;
+        }
+    } else if (w->dir == dir) {
+        w->held = false;
+    }
+    return true;
+}
+
+// Adds this tick's detents to report; returns true if there are any
+static bool wheel_task(report_mouse_t *report) {
+    if (!wheel_active || timer_elapsed(wheel_timer) < WHEEL_TICK_MS) {
+        return false;
+    }
+    wheel_timer = timer_read();
+
+    wheel_curve_t curve;
+    wheel_curve_for(current_os, &curve);
+
+    int8_t steps[WHEEL_AXIS_COUNT];
+    bool   active = false;
+
+    for (uint8_t i = 0; i < WHEEL_AXIS_COUNT; i++) {
+        wheel_axis_t *w = &wheel_axes[i];
+
+        if (w->held) {
+            w->speed = (w->speed + curve.accel < curve.max) ? w->speed + curve.accel : curve.max;
+        } else if (w->speed) {
+            w->speed -= (w->speed >> curve.decay) + 1;
+            if (w->speed < WHEEL_STOP_SPEED) {
+                w->speed     = 0;
+                w->remainder = 0;
+            }
+        }
+
+        w->remainder += w->dir * (int16_t)w->speed;
+        steps[i] = w->remainder / 256;
+        w->remainder -= steps[i] * 256;
+
+        active |= w->held || w->speed;
+    }
+    wheel_active = active;
+
+    report->v = steps[WHEEL_AXIS_V];
+    report->h = steps[WHEEL_AXIS_H];
+    return report->v || report->h;
+}
+#endif // KINETIC_WHEEL_ENABLE
+
+// ============================================================================
+// Cursor Motion
+// ============================================================================
+// MS_LEFT/MS_DOWN/MS_UP/MS_RGHT drive a cursor engine instead of the stock
+// mousekey stepping. Speed is kept in 1/256 pixel per tick and motion is
+// accumulated with sub-pixel precision, so slow speeds glide instead of
+// jumping. Diagonals are scaled by 1/sqrt(2), and holding
+// CURSOR_PRECISION_MODS divides the speed for fine positioning. All curve
+// parameters are compile-time constants.
+
+#ifdef CURSOR_ENGINE_ENABLE
+
+#ifndef CURSOR_TICK_MS
+    #define CURSOR_TICK_MS 8
+#endif
+#ifndef CURSOR_START_SPEED
+    #define CURSOR_START_SPEED 256  // 1 px per tick
+#endif
+#ifndef CURSOR_ACCEL_DELAY
+    #define CURSOR_ACCEL_DELAY 10   // ticks at start speed before accelerating
+#endif
+#ifndef CURSOR_ACCEL
+    #define CURSOR_ACCEL 24         // added to the speed every tick
+#endif
+#ifndef CURSOR_MAX_SPEED
+    #define CURSOR_MAX_SPEED 3072   // 12 px per tick
+#endif
+#ifndef CURSOR_PRECISION_MODS
+    #define CURSOR_PRECISION_MODS MOD_MASK_SHIFT
+#endif
+#ifndef CURSOR_PRECISION_SHIFT
+    #define CURSOR_PRECISION_SHIFT 2  // speed / 4 while precision mods are held
+#endif
+
+_Static_assert(CURSOR_MAX_SPEED < 127 * 256, "cursor speed must fit a mouse report");
+
+enum cursor_dir {
+    CURSOR_LEFT  = (1 << 0),
+    CURSOR_RIGHT = (1 << 1),
+    CURSOR_UP    = (1 << 2),
+    CURSOR_DOWN  = (1 << 3),
+};
+
+static uint8_t  cursor_held;
+static uint16_t cursor_speed;
+static uint8_t  cursor_ticks;
+static int16_t  cursor_acc_x;
+static int16_t  cursor_acc_y;
+static uint16_t cursor_timer;
+
+static void cursor_key(uint16_t keycode, bool pressed) {
+    uint8_t dir;
+    switch (keycode) {
+        case MS_LEFT: dir = CURSOR_LEFT;  break;
+        case MS_RGHT: dir = CURSOR_RIGHT; break;
+        case MS_UP:   dir = CURSOR_UP;    break;
+        default:      dir = CURSOR_DOWN;  break;
+    }
+
+    if (!pressed) {
+        cursor_held &= ~dir;
+        return;
+    }
+
+    if (!cursor_held) {
+        // Start moving on the next scan, one pixel first like the stock keys
+        cursor_speed = CURSOR_START_SPEED;
+        cursor_ticks = 0;
+        cursor_acc_x = 0;
+        cursor_acc_y = 0;
+        cursor_timer = timer_read() - CURSOR_TICK_MS;
+    }
+    cursor_held |= dir;
+
+    if (dir & (CURSOR_LEFT | CURSOR_RIGHT)) {
+        cursor_acc_x = (dir == CURSOR_RIGHT) ? 255 : -255;
+    } else {
+        cursor_acc_y = (dir == CURSOR_DOWN) ? 255 : -255;
+    }
+}
+
+// Adds this tick's motion to report; returns true if the cursor moved
+static bool cursor_task(report_mouse_t *report) {
+    if (!cursor_held || timer_elapsed(cursor_timer) < CURSOR_TICK_MS) {
+        return false;
+    }
+    cursor_timer = timer_read();
+
+    if (cursor_ticks < CURSOR_ACCEL_DELAY) {
+        cursor_ticks++;
+    } else if (cursor_speed < CURSOR_MAX_SPEED) {
+        cursor_speed = (cursor_speed + CURSOR_ACCEL < CURSOR_MAX_SPEED) ? cursor_speed + CURSOR_ACCEL : CURSOR_MAX_SPEED;
+    }
+
+    int8_t dx = !!(cursor_held & CURSOR_RIGHT) - !!(cursor_held & CURSOR_LEFT);
+    int8_t dy = !!(cursor_held & CURSOR_DOWN) - !!(cursor_held & CURSOR_UP);
+
+    uint16_t speed = cursor_speed;
+    if (get_mods() & CURSOR_PRECISION_MODS) {
+        speed >>= CURSOR_PRECISION_SHIFT;
+    }
+    if (dx && dy) {
+        speed = ((uint32_t)speed * 181) >> 8;  // 1/sqrt(2)
+    }
+
+    cursor_acc_x += dx * (int16_t)speed;
+    cursor_acc_y += dy * (int16_t)speed;
+
+    report->x = cursor_acc_x / 256;
+    report->y = cursor_acc_y / 256;
+    cursor_acc_x -= report->x * 256;
+    cursor_acc_y -= report->y * 256;
+    return report->x || report->y;
+}
+#endif // CURSOR_ENGINE_ENABLE
+
+// ============================================================================
+// Mouse Report
+// ============================================================================
+// The wheel and cursor engines fill one report per scan, on top of the
+// mousekey buttons, so at most one mouse report goes out per scan.
+
+#if defined(KINETIC_WHEEL_ENABLE) || defined(CURSOR_ENGINE_ENABLE)
+static void mouse_engine_task(void) {
+    report_mouse_t report = mousekey_get_report();
+    bool           moved  = false;
+
+    report.x = 0;
+    report.y = 0;
+    report.v = 0;
+    report.h = 0;
+
+    #ifdef KINETIC_WHEEL_ENABLE
+    moved |= wheel_task(&report);
+    #endif
+    #ifdef CURSOR_ENGINE_ENABLE
+    moved |= cursor_task(&report);
+    #endif
+
+    if (moved) {
+        host_mouse_send(&report);
+    }
+}
+#endif
+
+// ============================================================================
+// HID Report Coalescing
+// ============================================================================
+// Wraps the host driver so keyboard, mouse and extrakey reports sent during a
+// scan are held and flushed once from housekeeping, keyboard first, then
+// mouse, then extrakey. A newer report replaces a held one only while both
+// move the same way from what the host last saw (all presses or all
+// releases), so a modifier and its key arrive in one report and a press and
+// release within one scan are still both sent. System and consumer reports
+// are compared per report id. Mouse motion is summed.
+
+#ifdef REPORT_COALESCE_ENABLE
+
+typedef struct {
+    report_keyboard_t keyboard;
+    report_keyboard_t keyboard_sent;
+    report_mouse_t    mouse;
+    report_extra_t    extra;
+    uint16_t          extra_sent[2];  // last usage per report id: system, consumer
+    bool              keyboard_pending;
+    bool              mouse_pending;
+    bool              extra_pending;
+} report_coalesce_t;
+
+static host_driver_t     coalesce_driver;
+static host_driver_t    *coalesce_target;
+static report_coalesce_t coalesce;
+
+#if defined(LATENCY_HISTOGRAM_ENABLE) && defined(CONSOLE_ENABLE)
+// Defined with the key latency histogram below
+static void latency_report_sent(void);
+#endif
+
+// True if every modifier and key held in inner is also held in outer
+static bool keyboard_report_contains(const report_keyboard_t *outer, const report_keyboard_t *inner) {
+    if (inner->mods & ~outer->mods) {
+        return false;
+    }
+    for (uint8_t i = 0; i < KEYBOARD_REPORT_KEYS; i++) {
+        if (!inner->keys[i]) {
+            continue;
+        }
+        bool found = false;
+        for (uint8_t j = 0; j < KEYBOARD_REPORT_KEYS && !found; j++) {
+            found = outer->keys[j] == inner->keys[i];
+        }
+        if (!found) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool extra_usage_contains(uint16_t outer, uint16_t inner) {
+    return inner == 0 || inner == outer;
+}
+
+static uint16_t *coalesce_extra_sent(uint8_t report_id) {
+    return &coalesce.extra_sent[report_id == REPORT_ID_CONSUMER];
+}
+
+static void coalesce_flush_keyboard(void) {
+    if (coalesce.keyboard_pending) {
+        coalesce.keyboard_pending = false;
+        coalesce.keyboard_sent    = coalesce.keyboard;
+        coalesce_target->send_keyboard(&coalesce.keyboard);
+        #if defined(LATENCY_HISTOGRAM_ENABLE) && defined(CONSOLE_ENABLE)
+        latency_report_sent();
+        #endif
+    }
+}
+
+static void coalesce_flush_mouse(void) {
+    if (coalesce.mouse_pending) {
+        coalesce.mouse_pending = false;
+        coalesce_target->send_mouse(&coalesce.mouse);
+    }
+}
+
+static void coalesce_flush_extra(void) {
+    if (coalesce.extra_pending) {
+        coalesce.extra_pending = false;
+        *coalesce_extra_sent(coalesce.extra.report_id) = coalesce.extra.usage;
+        coalesce_target->send_extra(&coalesce.extra);
+    }
+}
+
+static void coalesce_send_keyboard(report_keyboard_t *report) {
+    if (coalesce.keyboard_pending) {
+        const report_keyboard_t *sent = &coalesce.keyboard_sent, *held = &coalesce.keyboard;
+        bool pressing  = keyboard_report_contains(held, sent) && keyboard_report_contains(report, held);
+        bool releasing = keyboard_report_contains(sent, held) && keyboard_report_contains(held, report);
+        if (!pressing && !releasing) {
+            coalesce_flush_keyboard();
+        }
+    }
+    coalesce.keyboard         = *report;
+    coalesce.keyboard_pending = true;
+}
+
+// Motion is summed while the buttons stay the same and the sums still fit
+// the smallest report; a button change goes out as its own report
+static void coalesce_send_mouse(report_mouse_t *report) {
+    if (coalesce.mouse_pending) {
+        report_mouse_t *held = &coalesce.mouse;
+        int16_t         x    = held->x + report->x;
+        int16_t         y    = held->y + report->y;
+        int16_t         v    = held->v + report->v;
+        int16_t         h    = held->h + report->h;
+
+        if (held->buttons == report->buttons && x >= INT8_MIN && x <= INT8_MAX && y >= INT8_MIN && y <= INT8_MAX && v >= INT8_MIN && v <= INT8_MAX && h >= INT8_MIN && h <= INT8_MAX) {
+            held->x = x;
+            held->y = y;
+            held->v = v;
+            held->h = h;
+            return;
+        }
+        coalesce_flush_mouse();
+    }
+    coalesce.mouse         = *report;
+    coalesce.mouse_pending = true;
+}
+
+static void coalesce_send_extra(report_extra_t *report) {
+    if (coalesce.extra_pending) {
+        uint16_t sent = *coalesce_extra_sent(coalesce.extra.report_id), held = coalesce.extra.usage;
+        bool same      = coalesce.extra.report_id == report->report_id;
+        bool pressing  = extra_usage_contains(held, sent) && extra_usage_contains(report->usage, held);
+        bool releasing = extra_usage_contains(sent, held) && extra_usage_contains(held, report->usage);
+        if (!same || (!pressing && !releasing)) {
+            coalesce_flush_extra();
+        }
+    }
+    coalesce.extra         = *report;
+    coalesce.extra_pending = true;
+}
+
+// The protocol installs its driver after keyboard_post_init_user, so the
+// wrapper is put in place from housekeeping once a driver shows up
+static void report_coalesce_task(void) {
+    host_driver_t *driver = host_get_driver();
+    if (driver != &coalesce_driver) {
+        if (!driver) {
+            return;
+        }
+        coalesce_target               = driver;
+        coalesce_driver               = *driver;
+        coalesce_driver.send_keyboard = coalesce_send_keyboard;
+        coalesce_driver.send_mouse    = coalesce_send_mouse;
+        coalesce_driver.send_extra    = coalesce_send_extra;
+        host_set_driver(&coalesce_driver);
+    }
+
+    coalesce_flush_keyboard();
+    coalesce_flush_mouse();
+    coalesce_flush_extra();
+    #if defined(LATENCY_HISTOGRAM_ENABLE) && defined(CONSOLE_ENABLE)
+    // Keys that sent no keyboard report, such as layer and mouse keys
+    latency_report_sent();
+    #endif
+}
+#endif // REPORT_COALESCE_ENABLE
+
+// ============================================================================
+// OS-Agnostic Action Table
+// ============================================================================
+// Without OS_ACTIONS_ENABLE the SC_*, LANG_SW, LANG_EN and LANG_KO keycodes
+// still exist for the keymap but send nothing.
+
+#ifdef OS_ACTIONS_ENABLE
+
+static const uint16_t PROGMEM os_action_table[OS_ACTION_COUNT][OS_VARIANT_COUNT] = {
+#define OS_ACTION_ROW(kc, unsure, linux, windows, macos, ios) \
+    [OS_ACTION_##kc] = {                                    \
+        [OS_UNSURE]  = unsure,                              \
+        [OS_LINUX]   = linux,                               \
+        [OS_WINDOWS] = windows,                             \
+        [OS_MACOS]   = macos,                               \
+        [OS_IOS]     = ios,                                 \
+    },
+    OS_ACTIONS(OS_ACTION_ROW)
+#undef OS_ACTION_ROW
+};
+
+// Keycode registered on press for each action, so release always undoes
+// exactly that even if the detected OS changes while the key is held
+static uint16_t os_action_latched[OS_ACTION_COUNT];
+
+#if defined(OS_ACTION_REMAP_ENABLE) && defined(RAW_ENABLE)
+// Defined with the OS action remapping below
+static bool os_action_override_get(uint8_t action, uint8_t os, uint16_t *keycode);
+#endif
+
+// Keycode for an action on a given OS: runtime override, else table default
+static uint16_t os_action_keycode(uint8_t action, uint8_t os) {
+    #if defined(OS_ACTION_REMAP_ENABLE) && defined(RAW_ENABLE)
+    uint16_t keycode;
+    if (os_action_override_get(action, os, &keycode)) {
+        return keycode;
+    }
+    #endif
+    return pgm_read_word(&os_action_table[action][os]);
+}
+
+/**
+ * get_os_action - Keycode to send for an OS-aware action on the current OS
+ * Unknown os_variant_t values fall back to the OS_UNSURE column.
+ */
+uint16_t get_os_action(uint8_t action) {
+    uint8_t os = (current_os < OS_VARIANT_COUNT) ? current_os : OS_UNSURE;
+    return os_action_keycode(action, os);
+}
+
+// Defined with the input language tracking below
+static void lang_toggled(void);
+
+/**
+ * process_os_action - Single dispatch path for every OS-aware keycode
+ * Returns false when the keycode was handled here.
+ */
+static bool process_os_action(uint16_t keycode, keyrecord_t *record) {
+    uint16_t action = keycode - OS_ACTION_FIRST;
+    if (action >= OS_ACTION_COUNT) {
+        return true;
+    }
+
+    if (record->event.pressed) {
+        os_action_latched[action] = get_os_action(action);
+        LOG_EVENT(LOG_OS_ACTION, action, os_action_latched[action]);
+        if (action == OS_ACTION_LANG_SW) {
+            lang_toggled();
+        }
+    }
+
+    #ifdef KINETIC_WHEEL_ENABLE
+    // MW_* resolve to MS_WHL* for the OS scroll direction; the wheel engine
+    // takes it from there
+    if (wheel_key(os_action_latched[action], record->event.pressed)) {
+        return false;
+    }
+    #endif
+
+    if (record->event.pressed) {
+        register_code16(os_action_latched[action]);
+    } else {
+        unregister_code16(os_action_latched[action]);
+        os_action_latched[action] = KC_NO;
+    }
+    return false;
+}
+
+// ============================================================================
+// Input Language Tracking
+// ============================================================================
+// LANG_SW only toggles the host input method, so the expected state is
+// tracked per OS (a KVM switch keeps each host's state) and flipped by every
+// LANG_SW press, including a plain key that matches it (KC_RALT on Windows).
+// Where LANG_SW resolves to Caps Lock, the host lights the Caps Lock LED
+// while a non-Latin source is active, and the state is resynced from it.
+// LANG_EN and LANG_KO send LANG_SW only when the state differs; while it is
+// unknown they send it once and assume it took effect. That guess is wrong
+// whenever the host already had the target source, so with Shift held they
+// send nothing and only record the source the host shows.
+
+enum lang_state {
+    LANG_UNKNOWN,
+    LANG_ENGLISH,
+    LANG_KOREAN,
+};
+
+static uint8_t  lang_state[OS_VARIANT_COUNT];
+static uint16_t lang_latched;
+
+static void lang_toggled(void) {
+    uint8_t *state = &lang_state[current_os];
+    if (*state != LANG_UNKNOWN) {
+        *state = (*state == LANG_ENGLISH) ? LANG_KOREAN : LANG_ENGLISH;
+    }
+}
+
+static void lang_sync_led(led_t led_state) {
+    if (get_os_action(OS_ACTION_LANG_SW) == KC_CAPS) {
+        lang_state[current_os] = led_state.caps_lock ? LANG_KOREAN : LANG_ENGLISH;
+    }
+}
+
+static bool process_lang(uint16_t keycode, keyrecord_t *record) {
+    if (keycode != LANG_EN && keycode != LANG_KO) {
+        if (record->event.pressed && keycode == get_os_action(OS_ACTION_LANG_SW)) {
+            lang_toggled();
+        }
+        return true;
+    }
+
+    if (record->event.pressed) {
+        uint8_t target = (keycode == LANG_KO) ? LANG_KOREAN : LANG_ENGLISH;
+        if (get_mods() & MOD_MASK_SHIFT) {
+            lang_state[current_os] = target;
+        } else if (lang_state[current_os] != target && !lang_latched) {
+            lang_latched = get_os_action(OS_ACTION_LANG_SW);
+            register_code16(lang_latched);
+            lang_state[current_os] = target;
+        }
+    } else if (lang_latched) {
+        unregister_code16(lang_latched);
+        lang_latched = KC_NO;
+    }
+    return false;
+}
+#endif // OS_ACTIONS_ENABLE
+
+// ============================================================================
+// User EEPROM Datablock
+// ============================================================================
+// Settings changed at runtime (OS action overrides, learned tapping terms)
+// live in one RAM mirror of the user EEPROM datablock. Saving waits for
+// USER_DATA_SAVE_DELAY without further changes, then writes one changed byte
+// per USER_DATA_SAVE_BYTE_MS from housekeeping, so a burst of edits costs one
+// pass of byte writes and the scan loop never waits for the EEPROM.
+
+#if (defined(OS_ACTION_REMAP_ENABLE) && defined(RAW_ENABLE)) || defined(ADAPTIVE_TERM_ENABLE)
+#define USER_DATA_ENABLE
+
+#ifndef OS_ACTION_OVERRIDE_COUNT
+    #define OS_ACTION_OVERRIDE_COUNT 8
+#endif
+#ifndef ADAPTIVE_TERM_SLOTS
+    #define ADAPTIVE_TERM_SLOTS 4
+#endif
+#ifndef USER_DATA_SAVE_DELAY
+    #define USER_DATA_SAVE_DELAY 2000
+#endif
+#ifndef USER_DATA_SAVE_BYTE_MS
+    #define USER_DATA_SAVE_BYTE_MS 4  // an AVR EEPROM byte write takes ~3.4ms
+#endif
+
+// keycode == KC_NO marks an unused entry, so a cleared datablock has none
+typedef struct __attribute__((packed)) {
+    uint8_t  action;
+    uint8_t  os;
+    uint16_t keycode;
+} os_action_override_t;
+
+// Learned tapping term of one tap-hold keycode
+typedef struct __attribute__((packed)) {
+    uint16_t keycode;
+    uint16_t term;
+} tapping_term_entry_t;
+
+// The layout does not depend on which features are enabled
+typedef struct __attribute__((packed)) {
+    os_action_override_t os_action_overrides[OS_ACTION_OVERRIDE_COUNT];
+    tapping_term_entry_t tapping_terms[ADAPTIVE_TERM_SLOTS];
+} user_data_t;
+
+_Static_assert(sizeof(user_data_t) <= EECONFIG_USER_DATA_SIZE, "EECONFIG_USER_DATA_SIZE too small for user_data_t");
+
+static user_data_t user_data;
+static bool        user_data_save_pending;
+static uint8_t     user_data_save_offset;
+static uint16_t    user_data_save_timer;
+
+static void user_data_init(void) {
+    eeconfig_read_user_datablock(&user_data, 0, sizeof(user_data));
+}
+
+static void user_data_save_later(void) {
+    user_data_save_pending = true;
+    user_data_save_offset  = 0;
+    user_data_save_timer   = timer_read();
+}
+
+// Writes at most one changed EEPROM byte per call
+static void user_data_save_task(void) {
+    if (!user_data_save_pending) {
+        return;
+    }
+    if (timer_elapsed(user_data_save_timer) < (user_data_save_offset ? USER_DATA_SAVE_BYTE_MS : USER_DATA_SAVE_DELAY)) {
+        return;
+    }
+
+    const uint8_t *ram = (const uint8_t *)&user_data;
+    while (user_data_save_offset < sizeof(user_data)) {
+        uint8_t offset = user_data_save_offset++;
+        uint8_t stored;
+        eeconfig_read_user_datablock(&stored, offset, 1);
+        if (stored != ram[offset]) {
+            eeconfig_update_user_datablock(&ram[offset], offset, 1);
+            user_data_save_timer = timer_read();
+            return;
+        }
+    }
+    user_data_save_pending = false;
+}
+#endif // USER_DATA_ENABLE
+
+// ============================================================================
+// OS Action Remapping
+// ============================================================================
+// A host tool (tools/os_action_map.py) can override what any OS action sends
+// on any OS over raw HID. Overrides are a short list of (action, os, keycode)
+// entries in the user datablock, applied immediately and saved to EEPROM in
+// the background.
+
+#if defined(OS_ACTION_REMAP_ENABLE) && defined(RAW_ENABLE)
+
+enum os_action_status {
+    OS_ACTION_OK,
+    OS_ACTION_INVALID,
+    OS_ACTION_FULL,
+};
+
+static bool os_action_override_get(uint8_t action, uint8_t os, uint16_t *keycode) {
+    for (uint8_t i = 0; i < OS_ACTION_OVERRIDE_COUNT; i++) {
+        const os_action_override_t *entry = &user_data.os_action_overrides[i];
+        if (entry->keycode != KC_NO && entry->action == action && entry->os == os) {
+            *keycode = entry->keycode;
+            return true;
+        }
+    }
+    return false;
+}
+
+// What process_os_action can send: a basic keycode with modifiers, or a
+// wheel direction for the wheel engine
+static inline bool os_action_keycode_valid(uint16_t keycode) {
+    return keycode <= QK_MODS_MAX || (keycode >= MS_WHLU && keycode <= MS_WHLR);
+}
+
+// Setting KC_NO removes the override and restores the table default
+static uint8_t os_action_override_set(uint8_t action, uint8_t os, uint16_t keycode) {
+    if (action >= OS_ACTION_COUNT || os >= OS_VARIANT_COUNT || !os_action_keycode_valid(keycode)) {
+        return OS_ACTION_INVALID;
+    }
+
+    os_action_override_t *slot = NULL;
+    for (uint8_t i = 0; i < OS_ACTION_OVERRIDE_COUNT; i++) {
+        os_action_override_t *entry = &user_data.os_action_overrides[i];
+        if (entry->keycode != KC_NO && entry->action == action && entry->os == os) {
+            slot = entry;
+            break;
+        }
+        if (!slot && entry->keycode == KC_NO) {
+            slot = entry;
+        }
+    }
+
+    if (!slot) {
+        return OS_ACTION_FULL;
+    }
+    if (slot->keycode == KC_NO && keycode == KC_NO) {
+        return OS_ACTION_OK;
+    }
+
+    slot->action  = action;
+    slot->os      = os;
+    slot->keycode = keycode;
+    user_data_save_later();
+    return OS_ACTION_OK;
+}
+
+/**
+ * os_action_raw_hid_get - Read the effective keycodes of one action
+ * Request: [cmd, action]
+ * Reply:   [cmd, action, status, action count, os count, keycode per os (LE)]
+ */
+static void os_action_raw_hid_get(uint8_t *data, uint8_t length) {
+    uint8_t action = data[1];
+
+    data[2] = OS_ACTION_OK;
+    data[3] = OS_ACTION_COUNT;
+    data[4] = OS_VARIANT_COUNT;
+    if (action >= OS_ACTION_COUNT) {
+        data[2] = OS_ACTION_INVALID;
+        return;
+    }
+    for (uint8_t os = 0; os < OS_VARIANT_COUNT; os++) {
+        uint16_t keycode = os_action_keycode(action, os);
+        data[5 + os * 2] = keycode & 0xFF;
+        data[6 + os * 2] = keycode >> 8;
+    }
+}
+
+/**
+ * os_action_raw_hid_set - Override one action on one OS
+ * Request: [cmd, action, os, keycode (LE)]
+ * Reply:   [cmd, action, os, status]
+ */
+static void os_action_raw_hid_set(uint8_t *data, uint8_t length) {
+    data[3] = os_action_override_set(data[1], data[2], data[3] | (data[4] << 8));
+}
+
+/**
+ * os_action_raw_hid_reset - Drop every override
+ * Request: [cmd]
+ * Reply:   [cmd, status]
+ */
+static void os_action_raw_hid_reset(uint8_t *data, uint8_t length) {
+    memset(user_data.os_action_overrides, 0, sizeof(user_data.os_action_overrides));
+    user_data_save_later();
+    data[1] = OS_ACTION_OK;
+}
+#endif // OS_ACTION_REMAP_ENABLE && RAW_ENABLE
+
+// ============================================================================
+// OS-Aware Macros
+// ============================================================================
+// The shortcut for the current OS goes down on press and up on release, so
+// holding GO_BACK repeats it like holding the shortcut would. The OS is
+// resolved on press and the sent shortcut is remembered per macro, so an OS
+// change while the key is held still releases what was pressed.
+
+#ifdef OS_MACROS_ENABLE
+
+static const uint16_t PROGMEM os_macro_table[OS_MACRO_COUNT][OS_VARIANT_COUNT] = {
+#define OS_MACRO_ROW(kc, unsure, linux, windows, macos, ios) \
+    [OS_MACRO_##kc] = {                                    \
+        [OS_UNSURE]  = unsure,                             \
+        [OS_LINUX]   = linux,                              \
+        [OS_WINDOWS] = windows,                            \
+        [OS_MACOS]   = macos,                              \
+        [OS_IOS]     = ios,                                \
+    },
+    OS_MACROS(OS_MACRO_ROW)
+#undef OS_MACRO_ROW
+};
+
+static uint16_t os_macro_held[OS_MACRO_COUNT];
+
+static bool process_os_macro(uint16_t keycode, keyrecord_t *record) {
+    uint16_t macro = keycode - OS_MACRO_FIRST;
+    if (macro >= OS_MACRO_COUNT) {
+        return true;
+    }
+
+    if (record->event.pressed) {
+        uint8_t os = (current_os < OS_VARIANT_COUNT) ? current_os : OS_UNSURE;
+        os_macro_held[macro] = pgm_read_word(&os_macro_table[macro][os]);
+        register_code16(os_macro_held[macro]);
+    } else if (os_macro_held[macro]) {
+        unregister_code16(os_macro_held[macro]);
+        os_macro_held[macro] = KC_NO;
+    }
+    return false;
+}
+#endif // OS_MACROS_ENABLE
+
+// ============================================================================
+// Eager Debounce
+// ============================================================================
+// Replaces QMK's default deferred debounce (DEBOUNCE_TYPE = custom): a press
+// is reported on its first edge and the key then ignores bounce for DEBOUNCE
+// ms; a release is reported only once the key has read open for DEBOUNCE ms
+// in a row. Presses lose the whole debounce window of latency, releases keep
+// it, so a bouncing contact can never produce an extra press.
+//
+// State is bit-packed per row plus one countdown byte per key, and only rows
+// whose raw state differs from the debounced one or that have a countdown
+// running are visited.
+
+#ifdef EAGER_DEBOUNCE_ENABLE
+
+#ifndef DEBOUNCE
+    #define DEBOUNCE 5
+#endif
+
+_Static_assert(DEBOUNCE > 0 && DEBOUNCE < 256, "DEBOUNCE must fit the per-key countdown");
+_Static_assert(MATRIX_ROWS <= 16, "debounce_active_rows holds one bit per row");
+
+static uint8_t      debounce_counters[MATRIX_ROWS][MATRIX_COLS];  // ms left, 0 = idle
+static matrix_row_t debounce_releasing[MATRIX_ROWS];  // countdown is a pending release
+static uint16_t     debounce_active_rows;             // rows with a countdown running
+static uint16_t     debounce_last_time;
+
+void debounce_init(uint8_t num_rows) {
+    memset(debounce_counters, 0, sizeof(debounce_counters));
+    memset(debounce_releasing, 0, sizeof(debounce_releasing));
+    debounce_active_rows = 0;
+    debounce_last_time   = timer_read();
+}
+
+// Counts down the running timers of a row. An expired release is committed
+// if the key still reads open; an expired press lockout on a key that already
+// reads open starts its release.
+static bool debounce_tick_row(uint8_t row, uint8_t elapsed, matrix_row_t raw, matrix_row_t *cooked) {
+    bool     cooked_changed = false;
+    uint8_t *counters       = debounce_counters[row];
+    bool     running        = false;
+
+    for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+        if (!counters[col]) {
+            continue;
+        }
+        if (counters[col] > elapsed) {
+            counters[col] -= elapsed;
+            running = true;
+            continue;
+        }
+
+        matrix_row_t bit = MATRIX_ROW_SHIFTER << col;
+        counters[col]    = 0;
+        if (raw & bit) {
+            debounce_releasing[row] &= ~bit;
+        } else if (debounce_releasing[row] & bit) {
+            debounce_releasing[row] &= ~bit;
+            *cooked &= ~bit;
+            cooked_changed = true;
+        } else {
+            debounce_releasing[row] |= bit;
+            counters[col] = DEBOUNCE;
+            running       = true;
+        }
+    }
+    if (!running) {
+        debounce_active_rows &= ~(1U << row);
+    }
+    return cooked_changed;
+}
+
+// Starts or cancels timers for the keys whose raw state differs from cooked
+static bool debounce_update_row(uint8_t row, matrix_row_t raw, matrix_row_t *cooked) {
+    bool         cooked_changed = false;
+    uint8_t     *counters       = debounce_counters[row];
+    matrix_row_t delta          = raw ^ *cooked;
+
+    // Keys pressed again during a pending release stay pressed
+    matrix_row_t cancelled = debounce_releasing[row] & ~delta;
+    if (cancelled) {
+        debounce_releasing[row] &= ~cancelled;
+        for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+            if (cancelled & (MATRIX_ROW_SHIFTER << col)) {
+                counters[col] = 0;
+            }
+        }
+    }
+
+    for (uint8_t col = 0; delta; col++, delta >>= 1) {
+        if (!(delta & 1) || counters[col]) {
+            continue;
+        }
+
+        matrix_row_t bit = MATRIX_ROW_SHIFTER << col;
+        counters[col]    = DEBOUNCE;
+        if (raw & bit) {
+            *cooked |= bit;
+            cooked_changed = true;
+        } else {
+            debounce_releasing[row] |= bit;
+        }
+        debounce_active_rows |= 1U << row;
+    }
+    return cooked_changed;
+}
+
+bool debounce(matrix_row_t raw[], matrix_row_t cooked[], uint8_t num_rows, bool changed) {
+    bool     cooked_changed = false;
+    uint16_t now            = timer_read();
+    uint16_t elapsed        = TIMER_DIFF_16(now, debounce_last_time);
+
+    if (elapsed && debounce_active_rows) {
+        debounce_last_time = now;
+        uint8_t step       = elapsed > 255 ? 255 : elapsed;
+        for (uint8_t row = 0; row < num_rows; row++) {
+            if (debounce_active_rows & (1U << row)) {
+                cooked_changed |= debounce_tick_row(row, step, raw[row], &cooked[row]);
+            }
+        }
+    } else if (!debounce_active_rows) {
+        debounce_last_time = now;
+    }
+
+    // Raw edges only arrive on scans that report a change
+    if (!changed) {
+        return cooked_changed;
+    }
+    for (uint8_t row = 0; row < num_rows; row++) {
+        if (raw[row] != cooked[row] || debounce_releasing[row]) {
+            cooked_changed |= debounce_update_row(row, raw[row], &cooked[row]);
+        }
+    }
+    return cooked_changed;
+}
+#endif // EAGER_DEBOUNCE_ENABLE
+
+// ============================================================================
+// Key Latency Histogram
+// ============================================================================
+// Measures the time from the matrix scan that saw a key change to the end of
+// its processing, when the HID report for it has been queued: the end of
+// post_process_record_user for keys QMK handles, and the return from
+// process_record_user for keys the keymap handles itself, since QMK skips
+// post-processing for those. With report coalescing the report only goes
+// out from housekeeping, so the sample is kept open until the coalesced
+// report is flushed. Counts live in a fixed RAM histogram and are printed
+// with LAT_DUMP; tools/latency_stats.py turns the dump into p50/p99/max.
+
+#if defined(LATENCY_HISTOGRAM_ENABLE) && defined(CONSOLE_ENABLE)
+
+#ifndef LATENCY_BUCKET_COUNT
+    #define LATENCY_BUCKET_COUNT 16
+#endif
+#ifndef LATENCY_BUCKET_SHIFT
+    #define LATENCY_BUCKET_SHIFT 5  // bucket width = 32 ticks
+#endif
+
+#ifdef __AVR__
+    // Timer0 ticks (4us at 16MHz) on top of the millisecond counter
+    #define LATENCY_TICKS_PER_MS TIMER_RAW_TOP
+
+    static uint16_t latency_now(void) {
+        uint16_t ms, raw;
+        do {
+            ms  = timer_read();
+            raw = TIMER_RAW;
+        } while (ms != timer_read());
+        return ms * LATENCY_TICKS_PER_MS + raw;
+    }
+#else
+    #define LATENCY_TICKS_PER_MS 1
+
+    static uint16_t latency_now(void) {
+        return timer_read();
+    }
+#endif
+
+#ifndef LATENCY_PENDING_COUNT
+    #define LATENCY_PENDING_COUNT 8  // samples waiting for a coalesced report
+#endif
+
+static uint16_t latency_buckets[LATENCY_BUCKET_COUNT];
+static uint16_t latency_max;
+static uint16_t latency_scan_start;
+static uint16_t latency_scan_ms;
+#ifdef REPORT_COALESCE_ENABLE
+static uint16_t latency_pending[LATENCY_PENDING_COUNT];  // start, in ticks
+static uint8_t  latency_pending_count;
+#endif
+
+// Marks the end of the matrix scan whose key changes are processed next
+static inline void latency_scan_mark(void) {
+    latency_scan_start = latency_now();
+    latency_scan_ms    = timer_read();
+}
+
+static void latency_sample(uint16_t ticks) {
+    uint16_t bucket = ticks >> LATENCY_BUCKET_SHIFT;
+    if (bucket >= LATENCY_BUCKET_COUNT) {
+        bucket = LATENCY_BUCKET_COUNT - 1;
+    }
+    if (latency_buckets[bucket] < UINT16_MAX) {
+        latency_buckets[bucket]++;
+    }
+    if (ticks > latency_max) {
+        latency_max = ticks;
+    }
+}
+
+static void latency_record(keyrecord_t *record) {
+    uint16_t ticks;
+
+    // Events held back by tap-hold or combos are older than the last scan
+    uint16_t age_ms = TIMER_DIFF_16(latency_scan_ms, record->event.time);
+    if (age_ms > 1) {
+        ticks = (age_ms < UINT16_MAX / LATENCY_TICKS_PER_MS) ? age_ms * LATENCY_TICKS_PER_MS : UINT16_MAX;
+    } else {
+        ticks = latency_now() - latency_scan_start;
+    }
+
+    #ifdef REPORT_COALESCE_ENABLE
+    // Finished by latency_report_sent; a sample that could wrap the 16-bit
+    // tick counter before then is already in the last bucket
+    if (ticks < UINT16_MAX / 2 && latency_pending_count < LATENCY_PENDING_COUNT) {
+        latency_pending[latency_pending_count++] = latency_now() - ticks;
+        return;
+    }
+    #endif
+    latency_sample(ticks);
+}
+
+#ifdef REPORT_COALESCE_ENABLE
+// Called by the report coalescing once the held reports reach the host
+static void latency_report_sent(void) {
+    uint16_t now = latency_now();
+    for (uint8_t i = 0; i < latency_pending_count; i++) {
+        latency_sample(now - latency_pending[i]);
+    }
+    latency_pending_count = 0;
+}
+#endif
+
+static void latency_dump(void) {
+    uprintf("LAT %u %u %u", (unsigned)LATENCY_TICKS_PER_MS, (unsigned)(1 << LATENCY_BUCKET_SHIFT), latency_max);
+    for (uint8_t i = 0; i < LATENCY_BUCKET_COUNT; i++) {
+        uprintf(" %u", latency_buckets[i]);
+    }
+    uprintf("\n");
+}
+
+static void latency_reset(void) {
+    memset(latency_buckets, 0, sizeof(latency_buckets));
+    latency_max = 0;
+}
+
+void matrix_scan_user(void) {
+    latency_scan_mark();
+}
+
+void post_process_record_user(uint16_t keycode, keyrecord_t *record) {
+    latency_record(record);
+}
+
+#endif // LATENCY_HISTOGRAM_ENABLE && CONSOLE_ENABLE
+
+// ============================================================================
+// RGB Idle Scaling
+// ============================================================================
+// After RGB_IDLE_DIM_TIMEOUT without matrix activity the RGB matrix renders
+// at a lower frame rate and reduced brightness. After RGB_MATRIX_TIMEOUT
+// (see config.h) QMK itself renders black frames; those carry nothing new,
+// so they are flushed once a second (the 16-bit frame interval cannot stop
+// them altogether). The enable flag and the effect are never touched. The
+// frame interval is fed to rgb_matrix through RGB_MATRIX_LED_FLUSH_LIMIT.
+// Wake-up is checked from housekeeping, which runs after the matrix task,
+// so the first key after an idle period is reported before any RGB work
+// happens.
+
+#if defined(RGB_IDLE_ENABLE) && defined(RGB_MATRIX_ENABLE)
+
+#ifndef RGB_IDLE_DIM_TIMEOUT
+    #define RGB_IDLE_DIM_TIMEOUT 30000     // 30 seconds
+#endif
+#ifndef RGB_IDLE_DIM_SHIFT
+    #define RGB_IDLE_DIM_SHIFT 1           // brightness / 2 while idle
+#endif
+
+enum rgb_idle_level { RGB_IDLE_ACTIVE, RGB_IDLE_DIM, RGB_IDLE_OFF };
+
+static const uint16_t PROGMEM rgb_idle_frame_table[] = {
+    [RGB_IDLE_ACTIVE] = 16,          // ~60 fps
+    [RGB_IDLE_DIM]    = 64,          // ~15 fps
+    [RGB_IDLE_OFF]    = 1000,        // black frames past RGB_MATRIX_TIMEOUT
+};
+
+uint16_t rgb_idle_frame_ms = 16;
+
+static uint8_t rgb_idle_level = RGB_IDLE_ACTIVE;
+static uint8_t rgb_idle_saved_val;
+static uint8_t rgb_idle_dimmed_val;
+
+// Defined with the split state sync below
+static void split_state_mark_dirty(void);
+
+static void rgb_idle_set_level(uint8_t level) {
+    if (level == rgb_idle_level) {
+        return;
+    }
+
+    // Brightness is synced to the other half by QMK, so only the master dims
+    if (is_keyboard_master()) {
+        hsv_t hsv = rgb_matrix_get_hsv();
+        if (rgb_idle_level == RGB_IDLE_ACTIVE) {
+            rgb_idle_saved_val  = hsv.v;
+            rgb_idle_dimmed_val = hsv.v >> RGB_IDLE_DIM_SHIFT;
+            rgb_matrix_sethsv_noeeprom(hsv.h, hsv.s, rgb_idle_dimmed_val);
+        } else if (level == RGB_IDLE_ACTIVE && hsv.v == rgb_idle_dimmed_val) {
+            // Leave brightness alone if it was changed while dimmed
+            rgb_matrix_sethsv_noeeprom(hsv.h, hsv.s, rgb_idle_saved_val);
+        }
+        split_state_mark_dirty();
+    }
+
+    rgb_idle_frame_ms = pgm_read_word(&rgb_idle_frame_table[level]);
+    rgb_idle_level    = level;
+}
+
+static void rgb_idle_task(void) {
+    if (!is_keyboard_master()) {
+        return;
+    }
+
+    uint32_t idle = last_matrix_activity_elapsed();
+    #if RGB_MATRIX_TIMEOUT > 0
+    if (idle > (uint32_t)RGB_MATRIX_TIMEOUT) {
+        rgb_idle_set_level(RGB_IDLE_OFF);
+    } else
+    #endif
+    if (idle >= RGB_IDLE_DIM_TIMEOUT) {
+        rgb_idle_set_level(RGB_IDLE_DIM);
+    } else {
+        rgb_idle_set_level(RGB_IDLE_ACTIVE);
+    }
+}
+#endif // RGB_IDLE_ENABLE && RGB_MATRIX_ENABLE
+
+// ============================================================================
+// Split State Sync
+// ============================================================================
+// current_os and the layer state only exist on the USB-connected half. This
+// ships them, together with indicator flags, to the other half over a custom
+// split transaction, and only when something changed since the last send.
+
+#ifdef SPLIT_KEYBOARD
+#include "transactions.h"
+
+typedef union {
+  uint16_t raw;
+  struct {
+    uint8_t os        : 3;  // os_variant_t
+    bool    caps_lock : 1;
+    uint8_t idle      : 2;  // rgb_idle_level
+    uint8_t reserved  : 2;
+    uint8_t layers;         // layer_state bits for layers 0-7
+  };
+} split_state_t;
+
+static split_state_t split_state;
+static bool split_state_dirty = true;
+
+static inline void split_state_mark_dirty(void) {
+    split_state_dirty = true;
+}
+
+static void split_state_slave_handler(uint8_t in_buflen, const void *in_data, uint8_t out_buflen, void *out_data) {
+    if (in_buflen != sizeof(split_state_t)) {
+        return;
+    }
+    memcpy(&split_state, in_data, sizeof(split_state_t));
+    current_os = split_state.os;
+    layer_state_set(split_state.layers);
+    #if defined(RGB_IDLE_ENABLE) && defined(RGB_MATRIX_ENABLE)
+    rgb_idle_set_level(split_state.idle);
+    #endif
+}
+
+static void split_state_init(void) {
+    transaction_register_rpc(USER_SYNC_STATE, split_state_slave_handler);
+}
+
+// Master side, once per scan: a single flag test unless the state changed
+static void split_state_task(void) {
+    if (!split_state_dirty || !is_keyboard_master()) {
+        return;
+    }
+
+    split_state_t next = {0};
+    next.os        = current_os;
+    next.caps_lock = host_keyboard_led_state().caps_lock;
+    next.layers    = (uint8_t)layer_state;
+    #if defined(RGB_IDLE_ENABLE) && defined(RGB_MATRIX_ENABLE)
+    next.idle      = rgb_idle_level;
+    #endif
+
+    // Stay dirty on a failed send so the next scan retries
+    if (next.raw == split_state.raw || transaction_rpc_send(USER_SYNC_STATE, sizeof(next), &next)) {
+        split_state       = next;
+        split_state_dirty = false;
+    }
+}
+#else
+static inline void split_state_mark_dirty(void) {}
+#endif // SPLIT_KEYBOARD
+
+// ============================================================================
+// RGB Indicators
+// ============================================================================
+// Drawn on top of whatever effect is running, from
+// rgb_matrix_indicators_advanced_user:
+//   - OS colour on OS_INDICATOR_KEYCODE on the base layer, and on every
+//     OS-aware key of an active upper layer (RGB_OS_INDICATOR_ENABLE)
+//   - layer colour on the other non-transparent keys of that layer
+//   - caps lock colour on the shift keys
+// Which LED gets which colour is recomputed only when the OS, layer, caps
+// lock or brightness change; each frame then only walks the LEDs of the
+// current render chunk.
+
+#if defined(RGB_INDICATORS_ENABLE) && defined(RGB_MATRIX_ENABLE)
+#include "keymap_introspection.h"
+
+enum indicator_class { IND_NONE, IND_OS, IND_LAYER, IND_CAPS, IND_CLASS_COUNT };
+
+#ifdef RGB_OS_INDICATOR_ENABLE
+#ifndef OS_INDICATOR_KEYCODE
+    #define OS_INDICATOR_KEYCODE KC_ESC
+#endif
+
+static const hsv_t PROGMEM os_indicator_hsv[OS_VARIANT_COUNT] = {
+    [OS_UNSURE]  = {  43, 255, 255 },  // Yellow for unsure/unknown
+    [OS_LINUX]   = {  85, 255, 255 },  // Green for Linux
+    [OS_WINDOWS] = { 170, 255, 255 },  // Blue for Windows
+    [OS_MACOS]   = {   0,   0, 255 },  // White for macOS/iOS
+    [OS_IOS]     = {   0,   0, 255 },
+};
+
+static bool is_os_aware_keycode(uint16_t keycode) {
+    return (uint16_t)(keycode - OS_ACTION_FIRST) < OS_ACTION_COUNT || (uint16_t)(keycode - OS_MACRO_FIRST) < OS_MACRO_COUNT;
+}
+
+static inline bool is_os_indicator_keycode(uint16_t keycode) {
+    return keycode == OS_INDICATOR_KEYCODE;
+}
+#else
+static inline bool is_os_aware_keycode(uint16_t keycode) { return false; }
+static inline bool is_os_indicator_keycode(uint16_t keycode) { return false; }
+#endif
+
+static const uint8_t PROGMEM layer_indicator_hue[] = {
+    [_BASIC]       = 0,
+    [_LEFT_UNDER]  = 128,  // Cyan
+    [_RIGHT_UNDER] = 213,  // Magenta
+    [_BOTH_UNDER]  = 21,   // Orange
+    [_LEFT_UP]     = 191,  // Purple
+};
+
+#define CAPS_INDICATOR_HUE 0  // Red
+
+typedef union {
+  uint32_t raw;
+  struct {
+    uint8_t os        : 3;
+    bool    caps_lock : 1;
+    uint8_t layer     : 4;
+    uint8_t val;
+  };
+} indicator_state_t;
+
+static indicator_state_t indicator_state = { .raw = UINT32_MAX };
+static uint8_t           indicator_class[(RGB_MATRIX_LED_COUNT + 3) / 4];  // 2 bits per LED
+static rgb_t             indicator_rgb[IND_CLASS_COUNT];
+
+static rgb_t indicator_color(uint8_t hue, uint8_t sat, uint8_t val) {
+    hsv_t hsv = { hue, sat, val };
+    return hsv_to_rgb(hsv);
+}
+
+static void indicator_mark(uint8_t row, uint8_t col, uint8_t cls) {
+    uint8_t led = g_led_config.matrix_co[row][col];
+    if (led >= RGB_MATRIX_LED_COUNT) {
+        return;
+    }
+    uint8_t shift = (led & 3) * 2;
+    indicator_class[led >> 2] = (indicator_class[led >> 2] & ~(3 << shift)) | (cls << shift);
+}
+
+static indicator_state_t indicator_current(void) {
+    indicator_state_t state = { .raw = 0 };
+    uint8_t           layer = get_highest_layer(layer_state);
+
+    #ifdef RGB_OS_INDICATOR_ENABLE
+    state.os    = (current_os < OS_VARIANT_COUNT) ? current_os : OS_UNSURE;
+    #endif
+    state.layer = (layer < ARRAY_SIZE(layer_indicator_hue)) ? layer : _BASIC;
+    state.val   = rgb_matrix_get_val();
+    #ifdef SPLIT_KEYBOARD
+    state.caps_lock = is_keyboard_master() ? host_keyboard_led_state().caps_lock : split_state.caps_lock;
+    #else
+    state.caps_lock = host_keyboard_led_state().caps_lock;
+    #endif
+    return state;
+}
+
+static void indicator_update(indicator_state_t state) {
+    #ifdef RGB_OS_INDICATOR_ENABLE
+    hsv_t os_hsv;
+    memcpy_P(&os_hsv, &os_indicator_hsv[state.os], sizeof(os_hsv));
+    indicator_rgb[IND_OS]    = indicator_color(os_hsv.h, os_hsv.s, state.val);
+    #endif
+    indicator_rgb[IND_LAYER] = indicator_color(pgm_read_byte(&layer_indicator_hue[state.layer]), 255, state.val);
+    indicator_rgb[IND_CAPS]  = indicator_color(CAPS_INDICATOR_HUE, 255, state.val);
+
+    memset(indicator_class, 0, sizeof(indicator_class));
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+            uint16_t base = keycode_at_keymap_location_raw(_BASIC, row, col);
+
+            if (state.layer != _BASIC) {
+                uint16_t keycode = keycode_at_keymap_location_raw(state.layer, row, col);
+                if (keycode != KC_TRNS && keycode != KC_NO) {
+                    indicator_mark(row, col, is_os_aware_keycode(keycode) ? IND_OS : IND_LAYER);
+                }
+            } else if (is_os_indicator_keycode(base)) {
+                indicator_mark(row, col, IND_OS);
+            }
+
+            if (state.caps_lock && (base == KC_LSFT || base == KC_RSFT)) {
+                indicator_mark(row, col, IND_CAPS);
+            }
+        }
+    }
+}
+
+bool rgb_matrix_indicators_advanced_user(uint8_t led_min, uint8_t led_max) {
+    indicator_state_t state = indicator_current();
+    if (state.raw != indicator_state.raw) {
+        indicator_update(state);
+        indicator_state = state;
+    }
+
+    for (uint8_t i = led_min; i < led_max; i++) {
+        uint8_t classes = indicator_class[i >> 2];
+        if (!classes) {
+            i |= 3;  // no indicator in this group of four LEDs
+            continue;
+        }
+        uint8_t cls = (classes >> ((i & 3) * 2)) & 3;
+        if (cls) {
+            rgb_matrix_set_color(i, indicator_rgb[cls].r, indicator_rgb[cls].g, indicator_rgb[cls].b);
+        }
+    }
+    return false;
+}
+#endif // RGB_INDICATORS_ENABLE && RGB_MATRIX_ENABLE
 
-enum custom_keycodes {
-  BASIC = SAFE_RANGE,
-  LEFT_UNDER,
-  RIGHT_UNDER,
-  BOTH_UNDER,
-  LEFT_UP,
-  // OS-agnostic screenshot keycodes
-  SC_FULL,      // Screenshot: Full screen capture
-  SC_AREA,      // Screenshot: Area selection
-  SC_MENU,      // Screenshot: Menu/Options (macOS only)
-  SC_CLIP_FULL, // Screenshot to clipboard: Full screen
-  SC_CLIP_AREA, // Screenshot to clipboard: Area selection
-  // OS-agnostic language switching
-  LANG_SW,      // Language/Input source switching
-  // OS-agnostic mouse wheel keycodes
-  MW_RIGHT,     // Mouse wheel right
-  MW_UP,        // Mouse wheel up
-  MW_DOWN,      // Mouse wheel down
-  MW_LEFT,      // Mouse wheel left
-};
+// ============================================================================
+// Tri-Layer Transitions
+// ============================================================================
+// LEFT_UNDER and RIGHT_UNDER switch _LEFT_UNDER/_RIGHT_UNDER and, while both
+// are held, _BOTH_UNDER. The resulting under-layer bits for each combination
+// of held thumb keys are precomputed, so a press or release is applied with
+// a single layer_state_set instead of layer_on/off plus update_tri_layer.
 
-// Legacy macOS-specific constants (kept for backward compatibility in keymap)
-const uint16_t KC_EMOJI = LGUI(LCTL(KC_SPACE));
-const uint16_t KC_AG = OSM(MOD_LALT|MOD_LGUI);
+#define UNDER_HELD_LEFT  (1 << 0)
+#define UNDER_HELD_RIGHT (1 << 1)
+#define UNDER_LAYER_MASK ((1 << _LEFT_UNDER) | (1 << _RIGHT_UNDER) | (1 << _BOTH_UNDER))
 
-const uint16_t GO_BACK = LGUI(KC_LBRC); // Go Backward on MacOS Browser
-const uint16_t GO_FORWARD = LGUI(KC_RBRC); // Go Forward on MacOS Browser
-const uint16_t GO_UPPER = LGUI(KC_UP); // Go Upper on MacOS Finder
-const uint16_t GO_LOWER = LGUI(KC_DOWN); // Go Lower on MacOS Finder
+static const uint8_t PROGMEM under_layer_table[4] = {
+    [0]                                  = 0,
+    [UNDER_HELD_LEFT]                    = (1 << _LEFT_UNDER),
+    [UNDER_HELD_RIGHT]                   = (1 << _RIGHT_UNDER),
+    [UNDER_HELD_LEFT | UNDER_HELD_RIGHT] = UNDER_LAYER_MASK,
+};
 
-const uint16_t TAP_P = LGUI(KC_GRV);
+static void under_layer_transition(uint16_t keycode, bool pressed) {
+    uint8_t held = 0;
+    if (layer_state & (1 << _LEFT_UNDER)) {
+        held |= UNDER_HELD_LEFT;
+    }
+    if (layer_state & (1 << _RIGHT_UNDER)) {
+        held |= UNDER_HELD_RIGHT;
+    }
 
-// BACKWARD COMPATIBILITY: Old macOS-specific screenshot shortcuts
-// These aliases map old keycodes to new OS-agnostic custom keycodes
-// User can replace these in keymap with SC_* keycodes directly
-#define KC_SG3  SC_FULL        // Full screen screenshot
-#define KC_SG4  SC_AREA        // Area selection screenshot
-#define KC_SG5  SC_MENU        // Screenshot menu
-#define KC_SGC3 SC_CLIP_FULL   // Full screen to clipboard
-#define KC_SGC4 SC_CLIP_AREA   // Area selection to clipboard
+    uint8_t key = (keycode == LEFT_UNDER) ? UNDER_HELD_LEFT : UNDER_HELD_RIGHT;
+    held = pressed ? (held | key) : (held & ~key);
 
-// OS detection variables for automatic mouse wheel direction adjustment
-static os_variant_t current_os = OS_UNSURE;
-static bool os_detected = false;
+    layer_state_set((layer_state & ~(layer_state_t)UNDER_LAYER_MASK) | pgm_read_byte(&under_layer_table[held]));
+}
 
 // ============================================================================
-// OS-Agnostic Helper Functions
+// OS Action Chords
 // ============================================================================
-// These functions return the appropriate keycode for each OS
+// Pressing the keys of a chord together on the base layer triggers an
+// OS-aware action. Chords are declared by base layer keycode and turned into
+// bitmasks over matrix positions (bit = row * MATRIX_COLS + col) at startup,
+// along with the chord each position belongs to; a key belongs to at most
+// one chord. A press is matched with one lookup and one mask compare, never
+// a walk over the chord list: keys outside every chord cost a single AND
+// and go straight through. Chord keys are held back until they complete
+// their chord, a key of anything else is pressed, or the chord term runs
+// out.
+//
+// Every press of a chord key waits for the next key or the term, and keys
+// pressed in a roll overlap, so each chord is two vertically adjacent keys
+// under the same finger, which typing never presses together, and none of
+// them is a letter (every letter is a jamo in Korean 2-set typing), a digit
+// or a modifier.
+//
+// Held-back keys are replayed from chord_task, after the scan's key events,
+// the way QMK's combos replay theirs: calling action_exec from inside
+// process_record_user would re-enter the tap-hold state machine, with
+// KC_AG possibly still waiting in it. Until the replay, every further event
+// joins the buffer so the host still sees the keys in the order they were
+// pressed.
 
-/**
- * get_screenshot_full - Full screen screenshot
- * macOS:   Cmd+Shift+3
- * Windows: Win+Shift+S (Snipping Tool)
- * Linux:   PrtScn
- */
-uint16_t get_screenshot_full(void) {
-    if (!os_detected) {
-        return LSG(KC_3);  // Default to macOS
-    }
-
-    switch (current_os) {
-        case OS_MACOS:
-        case OS_IOS:
-            return LSG(KC_3);  // Cmd+Shift+3
-        case OS_WINDOWS:
-            return G(S(KC_S));  // Win+Shift+S
-        case OS_LINUX:
-            return KC_PSCR;     // PrtScn
-        default:
-            return LSG(KC_3);   // Fallback to macOS
+#ifdef OS_CHORD_ENABLE
+
+// X(action, term_ms, key1, key2, key3); KC_NO for unused keys
+#define OS_CHORDS(X) \
+    X(LANG_SW,      30, KC_ESC,  KC_TAB,  KC_NO) \
+    X(SC_AREA,      40, KC_SCLN, KC_SLSH, KC_NO) \
+    X(SC_CLIP_AREA, 40, KC_DEL,  KC_QUOT, KC_NO)
+
+#define CHORD_MAX_KEYS 3
+
+#ifndef CHORD_BUFFER_SIZE
+    #define CHORD_BUFFER_SIZE 8  // held-back chord keys plus events queued behind them
+#endif
+
+_Static_assert(MATRIX_ROWS * MATRIX_COLS <= 64, "chord masks hold one bit per matrix position");
+_Static_assert(CHORD_BUFFER_SIZE > CHORD_MAX_KEYS, "the key that breaks a chord is buffered too");
+
+#define CHORD_BIT(row, col) ((uint64_t)1 << ((row) * MATRIX_COLS + (col)))
+
+typedef struct {
+    uint16_t action;
+    uint8_t  term;
+    uint16_t keys[CHORD_MAX_KEYS];
+} os_chord_t;
+
+static const os_chord_t PROGMEM os_chords[] = {
+#define OS_CHORD_ROW(action, term, key1, key2, key3) { action, term, { key1, key2, key3 } },
+    OS_CHORDS(OS_CHORD_ROW)
+#undef OS_CHORD_ROW
+};
+
+#define OS_CHORD_COUNT ARRAY_SIZE(os_chords)
+#define CHORD_NONE     0xFF
+
+_Static_assert(OS_CHORD_COUNT < CHORD_NONE, "chord indexes fit a byte");
+
+static uint64_t   chord_masks[OS_CHORD_COUNT];
+static uint8_t    chord_index[MATRIX_ROWS][MATRIX_COLS];  // chord of each position
+static uint64_t   chord_keys;     // every position used by some chord
+static uint64_t   chord_pending;  // chord keys held back so far
+static uint8_t    chord_pending_index;
+static uint64_t   chord_active;   // keys of the chord being held
+static int8_t     chord_active_index = -1;
+static keyevent_t chord_buffer[CHORD_BUFFER_SIZE];
+static uint8_t    chord_buffered;
+static uint16_t   chord_timer;
+static uint8_t    chord_term;
+static bool       chord_flushing;   // the buffer is replayed by chord_task
+static bool       chord_replaying;
+static bool       chord_held;       // the last event went into the buffer
+
+static void chord_init(void) {
+    memset(chord_index, CHORD_NONE, sizeof(chord_index));
+
+    for (uint8_t i = 0; i < OS_CHORD_COUNT; i++) {
+        uint64_t mask  = 0;
+        uint8_t  found = 0;
+        uint8_t  keys  = 0;
+
+        for (uint8_t k = 0; k < CHORD_MAX_KEYS; k++) {
+            uint16_t keycode = pgm_read_word(&os_chords[i].keys[k]);
+            if (keycode == KC_NO) {
+                continue;
+            }
+            keys++;
+            for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+                for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+                    if (keycode_at_keymap_location_raw(_BASIC, row, col) == keycode && !(mask & CHORD_BIT(row, col))) {
+                        mask |= CHORD_BIT(row, col);
+                        found++;
+                        row = MATRIX_ROWS;
+                        break;
+                    }
+                }
+            }
+        }
+
+        // A chord with a key missing from the base layer, or taken by an
+        // earlier chord, stays disabled
+        if (found != keys || (mask & chord_keys)) {
+            continue;
+        }
+        chord_masks[i] = mask;
+        chord_keys |= mask;
+        for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+            for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+                if (mask & CHORD_BIT(row, col)) {
+                    chord_index[row][col] = i;
+                }
+            }
+        }
     }
 }
 
-/**
- * get_screenshot_area - Area selection screenshot
- * macOS:   Cmd+Shift+4
- * Windows: Win+Shift+S (Snipping Tool)
- * Linux:   Shift+PrtScn
- */
-uint16_t get_screenshot_area(void) {
-    if (!os_detected) {
-        return LSG(KC_4);  // Default to macOS
-    }
-
-    switch (current_os) {
-        case OS_MACOS:
-        case OS_IOS:
-            return LSG(KC_4);   // Cmd+Shift+4
-        case OS_WINDOWS:
-            return G(S(KC_S));  // Win+Shift+S (same as full screen)
-        case OS_LINUX:
-            return S(KC_PSCR);  // Shift+PrtScn
-        default:
-            return LSG(KC_4);   // Fallback to macOS
+static void chord_send(uint16_t keycode, bool pressed) {
+    keyrecord_t record = { .event = { .pressed = pressed, .time = timer_read() } };
+    process_os_action(keycode, &record);
+}
+
+// Adds the event to the buffer; false when it is full and the event has to
+// go through unbuffered
+static bool chord_hold_back(keyrecord_t *record) {
+    if (chord_buffered >= CHORD_BUFFER_SIZE) {
+        return false;
     }
+    chord_buffer[chord_buffered++] = record->event;
+    chord_held                     = true;
+    return true;
 }
 
-/**
- * get_screenshot_menu - Screenshot menu/options
- * macOS:   Cmd+Shift+5 (Screenshot menu)
- * Windows: Not available (uses Snipping Tool)
- * Linux:   Not available
- */
-uint16_t get_screenshot_menu(void) {
-    if (!os_detected) {
-        return LSG(KC_5);  // Default to macOS
-    }
-
-    switch (current_os) {
-        case OS_MACOS:
-        case OS_IOS:
-            return LSG(KC_5);   // Cmd+Shift+5
-        case OS_WINDOWS:
-            return G(S(KC_S));  // Win+Shift+S (best alternative)
-        case OS_LINUX:
-            return KC_PSCR;     // PrtScn (best alternative)
-        default:
-            return LSG(KC_5);   // Fallback to macOS
+// The pending keys are not a chord: replay them from chord_task
+static void chord_flush(void) {
+    chord_flushing = true;
+    chord_pending  = 0;
+}
+
+// Feeds the buffer to the normal pipeline, in order, from outside it
+static void chord_replay(void) {
+    chord_replaying = true;
+    for (uint8_t i = 0; i < chord_buffered; i++) {
+        action_exec(chord_buffer[i]);
     }
+    chord_replaying = false;
+    chord_buffered  = 0;
+    chord_flushing  = false;
+}
+
+static void chord_fire(uint8_t index) {
+    chord_active       = chord_pending;
+    chord_active_index = index;
+    chord_pending      = 0;
+    chord_buffered     = 0;
+    chord_send(pgm_read_word(&os_chords[index].action), true);
 }
 
+
 /**
- * get_screenshot_clip_full - Full screen screenshot to clipboard
- * macOS:   Cmd+Ctrl+Shift+3
- * Windows: Win+Shift+S (goes to clipboard by default)
- * Linux:   Ctrl+PrtScn
+ * process_chord - Chord matching ahead of normal key processing
+ * Returns false when the event was held back or consumed by a chord.
  */
-uint16_t get_screenshot_clip_full(void) {
-    if (!os_detected) {
-        return LSG(LCTL(KC_3));  // Default to macOS
-    }
-
-    switch (current_os) {
-        case OS_MACOS:
-        case OS_IOS:
-            return LSG(LCTL(KC_3));  // Cmd+Ctrl+Shift+3
-        case OS_WINDOWS:
-            return G(S(KC_S));       // Win+Shift+S
-        case OS_LINUX:
-            return C(KC_PSCR);       // Ctrl+PrtScn
-        default:
-            return LSG(LCTL(KC_3));  // Fallback to macOS
+static bool process_chord(keyrecord_t *record) {
+    chord_held = false;
+    if (chord_replaying || record->event.key.row >= MATRIX_ROWS) {
+        return true;
+    }
+
+    // Queue behind a replay that has not run yet
+    if (chord_flushing) {
+        return !chord_hold_back(record);
+    }
+
+    uint64_t bit = CHORD_BIT(record->event.key.row, record->event.key.col);
+
+    if (!record->event.pressed) {
+        if (chord_active & bit) {
+            // The first released key ends the chord, the others are swallowed
+            if (chord_active_index >= 0) {
+                chord_send(pgm_read_word(&os_chords[chord_active_index].action), false);
+                chord_active_index = -1;
+            }
+            chord_active &= ~bit;
+            return false;
+        }
+        if (chord_pending & bit) {
+            chord_flush();
+            return !chord_hold_back(record);
+        }
+        return true;
+    }
+
+    uint8_t index = (chord_keys & bit) ? chord_index[record->event.key.row][record->event.key.col] : CHORD_NONE;
+    if (index == CHORD_NONE || layer_state != 0 || chord_active || (chord_pending && index != chord_pending_index)) {
+        // Anything else pressed meanwhile means no chord: keep key order
+        if (chord_pending) {
+            chord_flush();
+            return !chord_hold_back(record);
+        }
+        return true;
     }
+
+    if (!chord_pending) {
+        chord_timer         = record->event.time;
+        chord_term          = pgm_read_byte(&os_chords[index].term);
+        chord_pending_index = index;
+    }
+    chord_pending |= bit;
+    chord_hold_back(record);
+    if (chord_pending == chord_masks[index]) {
+        chord_fire(index);
+    }
+    return false;
 }
 
-/**
- * get_screenshot_clip_area - Area selection screenshot to clipboard
- * macOS:   Cmd+Ctrl+Shift+4
- * Windows: Win+Shift+S (goes to clipboard by default)
- * Linux:   Ctrl+Shift+PrtScn
- */
-uint16_t get_screenshot_clip_area(void) {
-    if (!os_detected) {
-        return LSG(LCTL(KC_4));  // Default to macOS
-    }
-
-    switch (current_os) {
-        case OS_MACOS:
-        case OS_IOS:
-            return LSG(LCTL(KC_4));  // Cmd+Ctrl+Shift+4
-        case OS_WINDOWS:
-            return G(S(KC_S));       // Win+Shift+S
-        case OS_LINUX:
-            return C(S(KC_PSCR));    // Ctrl+Shift+PrtScn
-        default:
-            return LSG(LCTL(KC_4));  // Fallback to macOS
+static void chord_task(void) {
+    if (chord_pending && timer_elapsed(chord_timer) >= chord_term) {
+        chord_flush();
+    }
+    if (chord_flushing) {
+        chord_replay();
     }
 }
+#endif // OS_CHORD_ENABLE
 
-/**
- * get_language_switch - Language/Input source switching
- * macOS:   Ctrl+Space (Spotlight/Input switching)
- * Windows: Right Alt (Language bar)
- * Linux:   Left Shift + Space (common default)
- */
-uint16_t get_language_switch(void) {
-    if (!os_detected) {
-        return LCTL(KC_SPC);  // Default to macOS
-    }
-
-    switch (current_os) {
-        case OS_MACOS:
-            return LCTL(KC_SPC);   // Ctrl+Space
-        case OS_IOS:
-            return KC_CAPS; // Caps Lock
-        case OS_WINDOWS:
-            return KC_RALT;      // Right Alt
-        case OS_LINUX:
-            return LSFT(KC_SPC);      // Left Shift + Space
-        default:
-            return LCTL(KC_SPC);   // Fallback to Ctrl+Space
+// ============================================================================
+// Key Event Trace
+// ============================================================================
+// Records every matrix key event as a 4-byte (time, row, col, pressed, layer)
+// entry in a single-producer/single-consumer ring buffer. process_record_user
+// only writes the head and the raw HID reader only advances the tail, so
+// neither side waits on the other; when the buffer is full, new events are
+// dropped and counted. tools/trace_stats.py drains the buffer over raw HID
+// and turns it into inter-key interval and layer usage statistics.
+
+#if defined(TRACE_RECORDER_ENABLE) && defined(RAW_ENABLE)
+
+#ifndef TRACE_BUFFER_SIZE
+    #define TRACE_BUFFER_SIZE 32
+#endif
+
+_Static_assert((TRACE_BUFFER_SIZE & (TRACE_BUFFER_SIZE - 1)) == 0, "TRACE_BUFFER_SIZE must be a power of two");
+_Static_assert(MATRIX_ROWS <= 16 && MATRIX_COLS <= 8, "trace events pack row and col into one byte");
+
+typedef struct __attribute__((packed)) {
+    uint16_t time;     // record->event.time, in ms
+    uint8_t  pos;      // row << 4 | pressed << 3 | col
+    uint8_t  layer;    // highest active layer
+} trace_event_t;
+
+static trace_event_t    trace_buffer[TRACE_BUFFER_SIZE];
+static volatile uint8_t trace_head;  // written by the producer only
+static volatile uint8_t trace_tail;  // written by the consumer only
+static uint16_t         trace_dropped;
+
+static void trace_record(keyrecord_t *record) {
+    if (record->event.key.row >= MATRIX_ROWS) {
+        return;  // combos and other virtual events
+    }
+    #ifdef OS_CHORD_ENABLE
+    if (chord_replaying) {
+        return;  // already recorded when it was held back
     }
+    #endif
+
+    uint8_t head = trace_head;
+    if ((uint8_t)(head - trace_tail) >= TRACE_BUFFER_SIZE) {
+        if (trace_dropped < UINT16_MAX) {
+            trace_dropped++;
+        }
+        return;
+    }
+
+    trace_event_t *event = &trace_buffer[head & (TRACE_BUFFER_SIZE - 1)];
+    event->time  = record->event.time;
+    event->pos   = (record->event.key.row << 4) | (record->event.pressed << 3) | record->event.key.col;
+    event->layer = get_highest_layer(layer_state);
+    trace_head   = head + 1;
 }
 
 /**
- * get_mouse_wheel - Mouse wheel direction mapping
- * macOS/iOS: Natural scrolling (MS_WHLR, MS_WHLU, MS_WHLD, MS_WHLL)
- * Windows/Linux: Reversed scrolling (MS_WHLL, MS_WHLD, MS_WHLU, MS_WHLR)
+ * trace_raw_hid_read - Fill a raw HID reply with buffered events
+ * Reply: [cmd, count, dropped_lo, dropped_hi, event 0, event 1, ...]
+ * The dropped counter is reset once it has been reported.
  */
-uint16_t get_mouse_wheel(uint16_t direction) {
-    bool is_mac = (current_os == OS_MACOS || current_os == OS_IOS);
-
-    switch (direction) {
-        case MW_RIGHT:
-            return is_mac ? MS_WHLR : MS_WHLL;
-        case MW_UP:
-            return is_mac ? MS_WHLU : MS_WHLD;
-        case MW_DOWN:
-            return is_mac ? MS_WHLD : MS_WHLU;
-        case MW_LEFT:
-            return is_mac ? MS_WHLL : MS_WHLR;
-        default:
-            return KC_NO;
+static void trace_raw_hid_read(uint8_t *data, uint8_t length) {
+    uint8_t  room  = (length - 4) / sizeof(trace_event_t);
+    uint8_t  tail  = trace_tail;
+    uint8_t  count = 0;
+
+    while (count < room && tail != trace_head) {
+        memcpy(&data[4 + count * sizeof(trace_event_t)], &trace_buffer[tail & (TRACE_BUFFER_SIZE - 1)], sizeof(trace_event_t));
+        tail++;
+        count++;
+    }
+    trace_tail = tail;
+
+    data[1]       = count;
+    data[2]       = trace_dropped & 0xFF;
+    data[3]       = trace_dropped >> 8;
+    trace_dropped = 0;
+}
+#endif // TRACE_RECORDER_ENABLE && RAW_ENABLE
+
+// ============================================================================
+// Adaptive Tapping Term
+// ============================================================================
+// Tap-hold keys (mod-tap, layer-tap, one-shot mods such as KC_AG) get their
+// own tapping term, learned from how long they are held when tapped: a
+// running average plus twice the average deviation and a safety margin,
+// clamped to [ADAPTIVE_TERM_MIN, ADAPTIVE_TERM_MAX]. Fast tappers get holds
+// resolved sooner, slow tappers stop misfiring. Learned terms are kept in the
+// user datablock and saved at most every ADAPTIVE_TERM_SAVE_INTERVAL.
+//
+// Clean taps alone can only lower a term that is too long: a tap that came
+// too late already resolved as a hold. So a hold released at most
+// ADAPTIVE_TERM_MISFIRE_WINDOW past the term, with no other key pressed
+// while it was down, is learned as a tap too, which raises the term past it.
+
+#ifdef ADAPTIVE_TERM_ENABLE
+
+#ifndef ADAPTIVE_TERM_MIN
+    #define ADAPTIVE_TERM_MIN 120
+#endif
+#ifndef ADAPTIVE_TERM_MAX
+    #define ADAPTIVE_TERM_MAX 300
+#endif
+#ifndef ADAPTIVE_TERM_MARGIN
+    #define ADAPTIVE_TERM_MARGIN 20
+#endif
+#ifndef ADAPTIVE_TERM_MIN_SAMPLES
+    #define ADAPTIVE_TERM_MIN_SAMPLES 8   // taps seen since boot before adapting
+#endif
+#ifndef ADAPTIVE_TERM_MISFIRE_WINDOW
+    #define ADAPTIVE_TERM_MISFIRE_WINDOW 100  // lone holds this far past the term were meant as taps
+#endif
+#ifndef ADAPTIVE_TERM_SAVE_INTERVAL
+    #define ADAPTIVE_TERM_SAVE_INTERVAL 600000  // 10 minutes
+#endif
+
+#define ADAPTIVE_TERM_EMA_DIVISOR 8
+
+typedef struct {
+    uint16_t tap_avg;
+    uint16_t tap_dev;
+    uint16_t pressed_at;
+    uint8_t  presses_at;  // adaptive_term_presses when it was pressed
+    uint8_t  samples;
+} adaptive_term_stats_t;
+
+static adaptive_term_stats_t adaptive_term_stats[ADAPTIVE_TERM_SLOTS];
+static uint8_t               adaptive_term_presses;  // every key press, wrapping
+static bool                  adaptive_term_changed;
+static uint32_t              adaptive_term_save_timer;
+
+static bool is_tap_hold_keycode(uint16_t keycode) {
+    return IS_QK_MOD_TAP(keycode) || IS_QK_LAYER_TAP(keycode) || IS_QK_ONE_SHOT_MOD(keycode);
+}
+
+// Slot of keycode, optionally claiming a free one
+static int8_t adaptive_term_slot(uint16_t keycode, bool claim) {
+    int8_t free_slot = -1;
+    for (uint8_t i = 0; i < ADAPTIVE_TERM_SLOTS; i++) {
+        if (user_data.tapping_terms[i].keycode == keycode) {
+            return i;
+        }
+        if (free_slot < 0 && user_data.tapping_terms[i].keycode == KC_NO) {
+            free_slot = i;
+        }
+    }
+    if (claim && free_slot >= 0) {
+        user_data.tapping_terms[free_slot].keycode = keycode;
+        user_data.tapping_terms[free_slot].term    = 0;
+    }
+    return claim ? free_slot : -1;
+}
+
+uint16_t get_tapping_term(uint16_t keycode, keyrecord_t *record) {
+    int8_t slot = adaptive_term_slot(keycode, false);
+    if (slot < 0) {
+        return TAPPING_TERM;
+    }
+
+    uint16_t term = user_data.tapping_terms[slot].term;
+    if (term < ADAPTIVE_TERM_MIN || term > ADAPTIVE_TERM_MAX) {
+        return TAPPING_TERM;
+    }
+    return term;
+}
+
+static void adaptive_term_record(uint16_t keycode, keyrecord_t *record) {
+    if (record->event.pressed) {
+        adaptive_term_presses++;
+    }
+    if (!is_tap_hold_keycode(keycode)) {
+        return;
+    }
+    int8_t slot = adaptive_term_slot(keycode, true);
+    if (slot < 0) {
+        return;
+    }
+
+    adaptive_term_stats_t *stats = &adaptive_term_stats[slot];
+    if (record->event.pressed) {
+        stats->pressed_at = record->event.time;
+        stats->presses_at = adaptive_term_presses;
+        return;
+    }
+
+    // Learn from clean taps, and from lone holds that only just missed the
+    // term; other holds say nothing about tap speed
+    uint16_t duration = TIMER_DIFF_16(record->event.time, stats->pressed_at);
+    if (record->tap.count == 0 || record->tap.interrupted) {
+        uint16_t term = get_tapping_term(keycode, record);
+        if (stats->presses_at != adaptive_term_presses || duration < term || duration > term + ADAPTIVE_TERM_MISFIRE_WINDOW) {
+            return;
+        }
+    }
+
+    if (stats->samples == 0) {
+        stats->tap_avg = duration;
+        stats->tap_dev = duration / 4;
+    } else {
+        int16_t error = (int16_t)(duration - stats->tap_avg);
+        stats->tap_avg += error / ADAPTIVE_TERM_EMA_DIVISOR;
+        stats->tap_dev += ((int16_t)abs(error) - (int16_t)stats->tap_dev) / ADAPTIVE_TERM_EMA_DIVISOR;
+    }
+    if (stats->samples < ADAPTIVE_TERM_MIN_SAMPLES) {
+        stats->samples++;
+        return;
+    }
+
+    uint16_t term = stats->tap_avg + 2 * stats->tap_dev + ADAPTIVE_TERM_MARGIN;
+    if (term < ADAPTIVE_TERM_MIN) {
+        term = ADAPTIVE_TERM_MIN;
+    } else if (term > ADAPTIVE_TERM_MAX) {
+        term = ADAPTIVE_TERM_MAX;
+    }
+    if (term != user_data.tapping_terms[slot].term) {
+        user_data.tapping_terms[slot].term = term;
+        adaptive_term_changed              = true;
+    }
+}
+
+static void adaptive_term_task(void) {
+    if (adaptive_term_changed && timer_elapsed32(adaptive_term_save_timer) >= ADAPTIVE_TERM_SAVE_INTERVAL) {
+        adaptive_term_changed    = false;
+        adaptive_term_save_timer = timer_read32();
+        user_data_save_later();
     }
 }
+#endif // ADAPTIVE_TERM_ENABLE
 
 const uint16_t PROGMEM keymaps[][MATRIX_ROWS][MATRIX_COLS] = {
 
@@ -330,7 +2250,7 @@ const uint16_t PROGMEM keymaps[][MATRIX_ROWS][MATRIX_COLS] = {
   //├────────┼────────┼────────┼────────┼────────┼────────┤                          ├────────┼────────┼────────┼────────┼────────┼────────┤
      KC_DEL,  _______, KC_LEFT, KC_RGHT, KC_UP,   KC_LBRC,                            KC_RBRC, KC_P4,   KC_P5,   KC_P6,   KC_PLUS, KC_PIPE,
   //├────────┼────────┼────────┼────────┼────────┼────────┼────────┐        ┌────────┼────────┼────────┼────────┼────────┼────────┼────────┤
-     KC_EMOJI,_______, _______, _______, KC_DOWN, KC_LCBR, KC_LPRN,          KC_RPRN, KC_RCBR, KC_P1,   KC_P2,   KC_P3,   KC_MINS, LANG_SW,
+     KC_EMOJI,LANG_EN, LANG_KO, _______, KC_DOWN, KC_LCBR, KC_LPRN,          KC_RPRN, KC_RCBR, KC_P1,   KC_P2,   KC_P3,   KC_MINS, LANG_SW,
   //└────────┴────────┴────────┴───┬────┴───┬────┴───┬────┴───┬────┘        └───┬────┴───┬────┴───┬────┴───┬────┴────────┴────────┴────────┘
                                     _______, _______, KC_DEL,                    KC_DEL,  _______, KC_P0
                                 // └────────┴────────┴────────┘                 └────────┴────────┴────────┘
@@ -366,7 +2286,7 @@ const uint16_t PROGMEM keymaps[][MATRIX_ROWS][MATRIX_COLS] = {
 
   [_LEFT_UP] = LAYOUT(
   //┌────────┬────────┬────────┬────────┬────────┬────────┐                          ┌────────┬────────┬────────┬────────┬────────┬────────┐
-     _______, _______, _______, _______, RM_TOGG, RM_NEXT,                    SC_CLIP_AREA, SC_CLIP_FULL, SC_MENU, SC_AREA, SC_FULL, _______,
+     LAT_DUMP,_______, _______, _______, RM_TOGG, RM_NEXT,                    SC_CLIP_AREA, SC_CLIP_FULL, SC_MENU, SC_AREA, SC_FULL, _______,
   //├────────┼────────┼────────┼────────┼────────┼────────┤                          ├────────┼────────┼────────┼────────┼────────┼────────┤
      _______, _______, _______, _______, RM_PREV, BL_STEP,                            MS_BTN1, MS_BTN2, MS_BTN3, MS_BTN4, GO_BACK, GO_FORWARD,
   //├────────┼────────┼────────┼────────┼────────┼────────┤                          ├────────┼────────┼────────┼────────┼────────┼────────┤
@@ -380,74 +2300,81 @@ const uint16_t PROGMEM keymaps[][MATRIX_ROWS][MATRIX_COLS] = {
 
 };
 
-bool process_record_user(uint16_t keycode, keyrecord_t *record) {
-  switch (keycode) {
-    // ========================================================================
-    // OS-Agnostic Screenshot Keycodes
-    // ========================================================================
-    case SC_FULL:
-      if (record->event.pressed) {
-        register_code16(get_screenshot_full());
-      } else {
-        unregister_code16(get_screenshot_full());
-      }
-      return false;
+static bool process_record_keymap(uint16_t keycode, keyrecord_t *record) {
+  LOG_EVENT(record->event.pressed ? LOG_KEY_DOWN : LOG_KEY_UP, keycode,
+            record->event.key.row << 8 | record->event.key.col);
 
-    case SC_AREA:
-      if (record->event.pressed) {
-        register_code16(get_screenshot_area());
-      } else {
-        unregister_code16(get_screenshot_area());
-      }
-      return false;
+#if defined(TRACE_RECORDER_ENABLE) && defined(RAW_ENABLE)
+  trace_record(record);
+#endif
 
-    case SC_MENU:
-      if (record->event.pressed) {
-        register_code16(get_screenshot_menu());
-      } else {
-        unregister_code16(get_screenshot_menu());
-      }
-      return false;
+#ifdef OS_CHORD_ENABLE
+  if (!process_chord(record)) {
+    return false;
+  }
+#endif
 
-    case SC_CLIP_FULL:
-      if (record->event.pressed) {
-        register_code16(get_screenshot_clip_full());
-      } else {
-        unregister_code16(get_screenshot_clip_full());
-      }
-      return false;
+#ifdef ADAPTIVE_TERM_ENABLE
+  adaptive_term_record(keycode, record);
+#endif
 
-    case SC_CLIP_AREA:
-      if (record->event.pressed) {
-        register_code16(get_screenshot_clip_area());
-      } else {
-        unregister_code16(get_screenshot_clip_area());
-      }
+#ifdef OS_ACTIONS_ENABLE
+  // OS-Agnostic Screenshot, Language Switching and Mouse Wheel keycodes
+  if (!process_os_action(keycode, record)) {
+    return false;
+  }
+
+  // Set-to-language keys and input language tracking
+  if (!process_lang(keycode, record)) {
+    return false;
+  }
+#endif
+
+#ifdef OS_MACROS_ENABLE
+  // OS-Agnostic browser/file manager navigation macros
+  if (!process_os_macro(keycode, record)) {
+    return false;
+  }
+#endif
+
+  switch (keycode) {
+    // ========================================================================
+    // Cursor Motion
+    // ========================================================================
+#ifdef CURSOR_ENGINE_ENABLE
+    case MS_LEFT:
+    case MS_DOWN:
+    case MS_UP:
+    case MS_RGHT:
+      cursor_key(keycode, record->event.pressed);
       return false;
+#endif
 
     // ========================================================================
-    // OS-Agnostic Language Switching
+    // Kinetic Mouse Wheel (MW_* are the plain wheel keys without OS_WHEEL)
     // ========================================================================
-    case LANG_SW:
-      if (record->event.pressed) {
-        register_code16(get_language_switch());
-      } else {
-        unregister_code16(get_language_switch());
-      }
+#if defined(KINETIC_WHEEL_ENABLE) && !defined(OS_WHEEL_ENABLE)
+    case MS_WHLU:
+    case MS_WHLD:
+    case MS_WHLL:
+    case MS_WHLR:
+      wheel_key(keycode, record->event.pressed);
       return false;
+#endif
 
     // ========================================================================
-    // OS-Agnostic Mouse Wheel
+    // Latency Histogram
     // ========================================================================
-    case MW_RIGHT:
-    case MW_UP:
-    case MW_DOWN:
-    case MW_LEFT:
+    case LAT_DUMP:
+#if defined(LATENCY_HISTOGRAM_ENABLE) && defined(CONSOLE_ENABLE)
       if (record->event.pressed) {
-        register_code16(get_mouse_wheel(keycode));
-      } else {
-        unregister_code16(get_mouse_wheel(keycode));
+        if (get_mods() & MOD_MASK_SHIFT) {
+          latency_reset();
+        } else {
+          latency_dump();
+        }
       }
+#endif
       return false;
 
     // ========================================================================
@@ -460,23 +2387,8 @@ bool process_record_user(uint16_t keycode, keyrecord_t *record) {
       return false;
       break;
     case LEFT_UNDER:
-      if (record->event.pressed) {
-        layer_on(_LEFT_UNDER);
-        update_tri_layer(_LEFT_UNDER, _RIGHT_UNDER, _BOTH_UNDER);
-      } else {
-        layer_off(_LEFT_UNDER);
-        update_tri_layer(_LEFT_UNDER, _RIGHT_UNDER, _BOTH_UNDER);
-      }
-      return false;
-      break;
     case RIGHT_UNDER:
-      if (record->event.pressed) {
-        layer_on(_RIGHT_UNDER);
-        update_tri_layer(_LEFT_UNDER, _RIGHT_UNDER, _BOTH_UNDER);
-      } else {
-        layer_off(_RIGHT_UNDER);
-        update_tri_layer(_LEFT_UNDER, _RIGHT_UNDER, _BOTH_UNDER);
-      }
+      under_layer_transition(keycode, record->event.pressed);
       return false;
       break;
     case BOTH_UNDER:
@@ -491,37 +2403,158 @@ bool process_record_user(uint16_t keycode, keyrecord_t *record) {
   return true;
 }
 
-// OS detection callback - automatically invoked when OS is detected
+bool process_record_user(uint16_t keycode, keyrecord_t *record) {
+  if (process_record_keymap(keycode, record)) {
+    return true;
+  }
+
+#if defined(LATENCY_HISTOGRAM_ENABLE) && defined(CONSOLE_ENABLE)
+#ifdef OS_CHORD_ENABLE
+  // Chord keys held back are measured when they are replayed
+  if (chord_held) {
+    return false;
+  }
+#endif
+  // QMK skips post_process_record_user for keys handled here
+  latency_record(record);
+#endif
+  return false;
+}
+
+void eeconfig_init_user(void) {
+    user_config.raw = 0;
+    user_config.last_os = OS_UNSURE;
+    eeconfig_update_user(user_config.raw);
+}
+
+void keyboard_post_init_user(void) {
+    // Warm start: use the last detected OS until detection completes
+    user_config.raw = eeconfig_read_user();
+    if (user_config.last_os < OS_VARIANT_COUNT && user_config.last_os != OS_UNSURE) {
+        current_os = user_config.last_os;
+    }
+
+    #ifdef USER_DATA_ENABLE
+    user_data_init();
+    #endif
+
+    #ifdef OS_CHORD_ENABLE
+    chord_init();
+    #endif
+
+    #ifdef SPLIT_KEYBOARD
+    split_state_init();
+    #endif
+}
+
+void housekeeping_task_user(void) {
+    #ifdef SPLIT_KEYBOARD
+    split_state_task();
+    #endif
+
+    #if defined(KINETIC_WHEEL_ENABLE) || defined(CURSOR_ENGINE_ENABLE)
+    mouse_engine_task();
+    #endif
+
+    #if defined(RGB_IDLE_ENABLE) && defined(RGB_MATRIX_ENABLE)
+    rgb_idle_task();
+    #endif
+
+    #ifdef ADAPTIVE_TERM_ENABLE
+    adaptive_term_task();
+    #endif
+
+    #ifdef USER_DATA_ENABLE
+    user_data_save_task();
+    #endif
+
+    #ifdef OS_CHORD_ENABLE
+    chord_task();
+    #endif
+
+    #if defined(EVENT_LOG_ENABLE) && defined(CONSOLE_ENABLE)
+    log_task();
+    #endif
+
+    // Last, so reports sent by the tasks above go out this scan
+    #ifdef REPORT_COALESCE_ENABLE
+    report_coalesce_task();
+    #endif
+}
+
+layer_state_t layer_state_set_user(layer_state_t state) {
+    LOG_EVENT(LOG_LAYER, state, 0);
+    split_state_mark_dirty();
+    return state;
+}
+
+bool led_update_user(led_t led_state) {
+    #ifdef OS_ACTIONS_ENABLE
+    lang_sync_led(led_state);
+    #endif
+    split_state_mark_dirty();
+    return true;
+}
+
+// OS detection callback - invoked when detection completes, including again
+// after USB re-enumeration (e.g. a KVM switching machines)
 bool process_detected_host_os_user(os_variant_t detected_os) {
-    current_os = detected_os;
-    os_detected = true;
-
-    // Optional: Visual feedback via RGB Matrix
-    #ifdef RGB_MATRIX_ENABLE
-    switch (detected_os) {
-        case OS_MACOS:
-        case OS_IOS:
-            // White color for macOS/iOS
-            rgb_matrix_mode_noeeprom(RGB_MATRIX_SOLID_COLOR);
-            rgb_matrix_sethsv_noeeprom(0, 0, 255);
+    LOG_EVENT(LOG_OS_DETECTED, detected_os, detected_os != OS_UNSURE ? detected_os : current_os);
+
+    // An inconclusive result keeps the cached OS instead of dropping back to
+    // macOS shortcuts
+    if (detected_os != OS_UNSURE) {
+        current_os = detected_os;
+        split_state_mark_dirty();
+
+        // Only touch EEPROM when the host actually changed
+        if (user_config.last_os != detected_os) {
+            user_config.last_os = detected_os;
+            eeconfig_update_user(user_config.raw);
+        }
+    }
+
+    return true;
+}
+
+// ============================================================================
+// Raw HID
+// ============================================================================
+// Host tools talk to the keyboard with 32-byte raw HID reports. The first
+// byte is the command and is echoed back in the reply; unknown commands are
+// answered with RAW_HID_UNHANDLED.
+
+#ifdef RAW_ENABLE
+enum raw_hid_command {
+    RAW_HID_TRACE_READ       = 0x01,  // Drain the key event trace
+    RAW_HID_OS_ACTION_GET    = 0x02,  // Read an OS action mapping
+    RAW_HID_OS_ACTION_SET    = 0x03,  // Override an OS action mapping
+    RAW_HID_OS_ACTION_RESET  = 0x04,  // Restore the default OS action mappings
+    RAW_HID_UNHANDLED        = 0xFF,
+};
+
+void raw_hid_receive(uint8_t *data, uint8_t length) {
+    switch (data[0]) {
+#if defined(TRACE_RECORDER_ENABLE)
+        case RAW_HID_TRACE_READ:
+            trace_raw_hid_read(data, length);
+            break;
+#endif
+#if defined(OS_ACTION_REMAP_ENABLE)
+        case RAW_HID_OS_ACTION_GET:
+            os_action_raw_hid_get(data, length);
             break;
-        case OS_WINDOWS:
-            // Blue color for Windows
-            rgb_matrix_mode_noeeprom(RGB_MATRIX_SOLID_COLOR);
-            rgb_matrix_sethsv_noeeprom(170, 255, 255);
+        case RAW_HID_OS_ACTION_SET:
+            os_action_raw_hid_set(data, length);
             break;
-        case OS_LINUX:
-            // Green color for Linux
-            rgb_matrix_mode_noeeprom(RGB_MATRIX_SOLID_COLOR);
-            rgb_matrix_sethsv_noeeprom(85, 255, 255);
+        case RAW_HID_OS_ACTION_RESET:
+            os_action_raw_hid_reset(data, length);
             break;
+#endif
         default:
-            // Yellow for unsure/unknown
-            rgb_matrix_mode_noeeprom(RGB_MATRIX_SOLID_COLOR);
-            rgb_matrix_sethsv_noeeprom(43, 255, 255);
+            data[0] = RAW_HID_UNHANDLED;
             break;
     }
-    #endif
-
-    return true;
+    raw_hid_send(data, length);
 }
+#endif // RAW_ENABLE
@@ -4,7 +4,7 @@
 BOOTMAGIC_ENABLE = no       # Enable Bootmagic Lite
 MOUSEKEY_ENABLE = yes        # Mouse keys
 EXTRAKEY_ENABLE = yes       # Audio control and System control
-CONSOLE_ENABLE = yes        # Console for debug
+CONSOLE_ENABLE = no         # Console for debug (turned on by the console features below)
 COMMAND_ENABLE = no         # Commands for debug and configuration
 NKRO_ENABLE = no            # Enable N-Key Rollover
 BACKLIGHT_ENABLE = no       # Enable keyboard backlight functionality
@@ -16,3 +16,107 @@ RGB_MATRIX_ENABLE = yes
 OS_DETECTION_ENABLE = yes
 
 LTO_ENABLE = yes
+
+# Keymap features
+#   change yes to no to disable; everything beyond the OS-aware keys and
+#   indicators is off by default: the last release was already within 14
+#   bytes of the 28K flash the bootloader leaves on the ATmega32u4, so check
+#   tools/footprint.py before turning more on
+#
+OS_ACTIONS_ENABLE = yes         # OS-aware SC_*, LANG_SW and LANG_EN/KO keys (send nothing when off)
+OS_WHEEL_ENABLE = yes           # MW_* scroll direction per OS (plain wheel keys when off)
+RGB_OS_INDICATOR_ENABLE = yes   # Detected OS colour on Esc and on OS-aware keys
+LEGACY_ALIASES_ENABLE = yes     # Old KC_SG* screenshot aliases for SC_*
+OS_MACROS_ENABLE = yes          # OS-aware GO_*, KC_EMOJI and TAP_P macros (send nothing when off)
+LATENCY_HISTOGRAM_ENABLE = no   # Key latency histogram, dumped to console with LAT_DUMP
+KINETIC_WHEEL_ENABLE = no       # Accelerating, inertial scrolling for the MW_* keys
+CURSOR_ENGINE_ENABLE = no       # Sub-pixel cursor motion with precision mode for MS_* keys
+RGB_IDLE_ENABLE = no            # Lower RGB frame rate and brightness while idle
+RGB_INDICATORS_ENABLE = yes     # OS, layer and caps lock indicators over the RGB effect
+TRACE_RECORDER_ENABLE = no      # Key event trace, read over raw HID by tools/trace_stats.py
+OS_ACTION_REMAP_ENABLE = no     # Edit OS action mappings over raw HID with tools/os_action_map.py
+OS_CHORD_ENABLE = no            # Chords on the base layer for OS actions (Esc+Tab: LANG_SW, ...)
+ADAPTIVE_TERM_ENABLE = no       # Per-key tapping term learned from tap durations
+EAGER_DEBOUNCE_ENABLE = no      # Report presses on the first edge, debounce releases only
+REPORT_COALESCE_ENABLE = no     # At most one keyboard, mouse and extrakey report per scan
+EVENT_LOG_ENABLE = no           # Binary event log on the console, decoded by tools/event_log.py
+
+# Features built on the OS action table
+ifneq ($(strip $(OS_ACTIONS_ENABLE)), yes)
+    OS_WHEEL_ENABLE = no
+    OS_ACTION_REMAP_ENABLE = no
+    OS_CHORD_ENABLE = no
+endif
+
+ifeq ($(strip $(OS_ACTIONS_ENABLE)), yes)
+    OPT_DEFS += -DOS_ACTIONS_ENABLE
+endif
+
+ifeq ($(strip $(OS_WHEEL_ENABLE)), yes)
+    OPT_DEFS += -DOS_WHEEL_ENABLE
+endif
+
+ifeq ($(strip $(RGB_OS_INDICATOR_ENABLE)), yes)
+    OPT_DEFS += -DRGB_OS_INDICATOR_ENABLE
+endif
+
+ifeq ($(strip $(LEGACY_ALIASES_ENABLE)), yes)
+    OPT_DEFS += -DLEGACY_ALIASES_ENABLE
+endif
+
+ifeq ($(strip $(OS_MACROS_ENABLE)), yes)
+    OPT_DEFS += -DOS_MACROS_ENABLE
+endif
+
+ifeq ($(strip $(LATENCY_HISTOGRAM_ENABLE)), yes)
+    CONSOLE_ENABLE = yes
+    OPT_DEFS += -DLATENCY_HISTOGRAM_ENABLE
+endif
+
+ifeq ($(strip $(KINETIC_WHEEL_ENABLE)), yes)
+    OPT_DEFS += -DKINETIC_WHEEL_ENABLE
+endif
+
+ifeq ($(strip $(CURSOR_ENGINE_ENABLE)), yes)
+    OPT_DEFS += -DCURSOR_ENGINE_ENABLE
+endif
+
+ifeq ($(strip $(RGB_IDLE_ENABLE)), yes)
+    OPT_DEFS += -DRGB_IDLE_ENABLE
+endif
+
+ifeq ($(strip $(RGB_INDICATORS_ENABLE)), yes)
+    OPT_DEFS += -DRGB_INDICATORS_ENABLE
+endif
+
+ifeq ($(strip $(TRACE_RECORDER_ENABLE)), yes)
+    RAW_ENABLE = yes
+    OPT_DEFS += -DTRACE_RECORDER_ENABLE
+endif
+
+ifeq ($(strip $(OS_ACTION_REMAP_ENABLE)), yes)
+    RAW_ENABLE = yes
+    OPT_DEFS += -DOS_ACTION_REMAP_ENABLE
+endif
+
+ifeq ($(strip $(OS_CHORD_ENABLE)), yes)
+    OPT_DEFS += -DOS_CHORD_ENABLE
+endif
+
+ifeq ($(strip $(ADAPTIVE_TERM_ENABLE)), yes)
+    OPT_DEFS += -DADAPTIVE_TERM_ENABLE
+endif
+
+ifeq ($(strip $(EAGER_DEBOUNCE_ENABLE)), yes)
+    DEBOUNCE_TYPE = custom
+    OPT_DEFS += -DEAGER_DEBOUNCE_ENABLE
+endif
+
+ifeq ($(strip $(REPORT_COALESCE_ENABLE)), yes)
+    OPT_DEFS += -DREPORT_COALESCE_ENABLE
+endif
+
+ifeq ($(strip $(EVENT_LOG_ENABLE)), yes)
+    CONSOLE_ENABLE = yes
+    OPT_DEFS += -DEVENT_LOG_ENABLE
+endif
@@ -0,0 +1,95 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+// Replays a typing trace through the keymap and reports events per second
+// and CPU cycles per event on the host. Each event gets its own scan, so the
+// figures include the per-scan work (housekeeping, report flushing) as well.
+// Host numbers only rank changes against each other; they are not AVR
+// timings.
+
+#include <stdio.h>
+
+#include "keymap.c"
+#include "keymap_introspection.c"
+
+#include "harness.h"
+
+#define BENCH_PASSES 2000
+
+typedef struct {
+    keypos_t key;
+    bool     pressed;
+} bench_event_t;
+
+static bench_event_t trace[512];
+static uint16_t      trace_length;
+
+static void trace_add(uint16_t keycode, bool pressed) {
+    trace[trace_length++] = (bench_event_t){ harness_key_pos(keycode), pressed };
+}
+
+static void trace_tap(uint16_t keycode) {
+    trace_add(keycode, true);
+    trace_add(keycode, false);
+}
+
+static void trace_build(void) {
+    static const char text[] = "The quick brown fox jumps over the lazy dog. Pack my box with five dozen liquor jugs";
+
+    for (const char *c = text; *c; c++) {
+        if (*c >= 'A' && *c <= 'Z') {
+            trace_add(KC_LSFT, true);
+            trace_tap(KC_A + (*c - 'A'));
+            trace_add(KC_LSFT, false);
+        } else if (*c >= 'a' && *c <= 'z') {
+            trace_tap(KC_A + (*c - 'a'));
+        } else if (*c == ' ') {
+            trace_tap(KC_SPC);
+        } else if (*c == '.') {
+            trace_tap(KC_DOT);
+        }
+    }
+
+    // Symbols through the tri-layer thumb keys and an OS action
+    trace_add(LEFT_UNDER, true);
+    trace_tap(KC_1);
+    trace_add(RIGHT_UNDER, true);
+    trace_tap(KC_TAB);
+    trace_add(RIGHT_UNDER, false);
+    trace_add(LEFT_UNDER, false);
+    trace_add(MO(_LEFT_UP), true);
+    trace_tap(KC_4);  // SC_AREA position
+    trace_add(MO(_LEFT_UP), false);
+    trace_tap(KC_ENT);
+}
+
+int main(void) {
+    harness_boot(OS_MACOS);
+    trace_build();
+
+    uint64_t ns     = harness_ns();
+    uint64_t cycles = harness_cycles();
+    for (uint16_t pass = 0; pass < BENCH_PASSES; pass++) {
+        harness_reports_clear();
+        for (uint16_t i = 0; i < trace_length; i++) {
+            harness_scan_begin();
+            harness_scan_key(trace[i].key, trace[i].pressed);
+            harness_scan_end();
+        }
+        harness_idle(50);  // chord terms run out between passes
+    }
+    ns     = harness_ns() - ns;
+    cycles = harness_cycles() - cycles;
+
+    uint32_t events = (uint32_t)trace_length * BENCH_PASSES;
+    printf("bench_keymap: typing trace, %u events: %.0f events/s, %.0f cycles/event\n", events, events * 1e9 / ns, (double)cycles / events);
+
+    uint64_t idle_cycles = harness_cycles();
+    harness_idle(100000);
+    idle_cycles = harness_cycles() - idle_cycles;
+    printf("bench_keymap: idle scan: %.0f cycles/scan\n", (double)idle_cycles / 100000);
+
+    harness_test("bench trace");
+    CHECK(keyboard_report_is(&harness_last_report(REPORT_KEYBOARD)->keyboard, KC_NO));
+    CHECK_EQ(layer_state, 0);
+    return harness_done("bench_keymap");
+}
@@ -0,0 +1,168 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include <stdio.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+    #include <x86intrin.h>
+#endif
+
+#include "harness.h"
+
+// ----------------------------------------------------------------------------
+// Key events
+// ----------------------------------------------------------------------------
+
+static bool key_pos_on(uint8_t layer, uint16_t keycode, keypos_t *pos) {
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+            if (keycode_at_keymap_location_raw(layer, row, col) == keycode) {
+                *pos = (keypos_t){ .col = col, .row = row };
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+keypos_t harness_key_pos_on(uint8_t layer, uint16_t keycode) {
+    keypos_t pos;
+    if (!key_pos_on(layer, keycode, &pos)) {
+        fprintf(stderr, "keycode 0x%04x is not on layer %u\n", keycode, layer);
+        exit(2);
+    }
+    return pos;
+}
+
+keypos_t harness_key_pos(uint16_t keycode) {
+    keypos_t pos;
+    for (uint8_t layer = 0; layer < 32; layer++) {
+        if (key_pos_on(layer, keycode, &pos)) {
+            return pos;
+        }
+    }
+    fprintf(stderr, "keycode 0x%04x is not in the keymap\n", keycode);
+    exit(2);
+}
+
+static void key_event(uint16_t keycode, bool pressed) {
+    harness_scan_begin();
+    harness_scan_key(harness_key_pos(keycode), pressed);
+    harness_scan_end();
+}
+
+void key_press(uint16_t keycode) {
+    key_event(keycode, true);
+}
+
+void key_release(uint16_t keycode) {
+    key_event(keycode, false);
+}
+
+void key_tap(uint16_t keycode) {
+    key_press(keycode);
+    key_release(keycode);
+}
+
+// ----------------------------------------------------------------------------
+// Reports
+// ----------------------------------------------------------------------------
+
+void harness_reports_clear(void) {
+    harness_report_count   = 0;
+    harness_report_dropped = 0;
+}
+
+uint16_t harness_count_reports(uint8_t type) {
+    uint16_t count = 0;
+    for (uint16_t i = 0; i < harness_report_count; i++) {
+        count += harness_reports[i].type == type;
+    }
+    return count;
+}
+
+const harness_report_t *harness_last_report(uint8_t type) {
+    static const harness_report_t none;
+    for (uint16_t i = harness_report_count; i > 0; i--) {
+        if (harness_reports[i - 1].type == type) {
+            return &harness_reports[i - 1];
+        }
+    }
+    return &none;
+}
+
+bool keyboard_report_is(const report_keyboard_t *report, uint16_t keycode) {
+    uint8_t basic = keycode & 0xFF;
+    uint8_t mods  = (keycode >> 8) & 0x1F;
+    mods          = (mods & 0x10) ? (mods & 0x0F) << 4 : mods;
+
+    if (basic >= KC_LCTL && basic <= KC_RGUI) {
+        mods |= MOD_BIT(basic);
+        basic = KC_NO;
+    }
+    if (report->mods != mods) {
+        return false;
+    }
+    for (uint8_t i = 0; i < KEYBOARD_REPORT_KEYS; i++) {
+        if (report->keys[i] && report->keys[i] != basic) {
+            return false;
+        }
+        if (report->keys[i] == basic) {
+            basic = KC_NO;
+        }
+    }
+    return basic == KC_NO;
+}
+
+// ----------------------------------------------------------------------------
+// Checks
+// ----------------------------------------------------------------------------
+
+static const char *current_test = "";
+static unsigned    checks;
+static unsigned    failures;
+
+void harness_test(const char *name) {
+    current_test = name;
+}
+
+bool harness_check(bool ok, const char *text, const char *file, int line) {
+    checks++;
+    if (!ok) {
+        failures++;
+        fprintf(stderr, "%s:%d: %s: check failed: %s\n", file, line, current_test, text);
+    }
+    return ok;
+}
+
+bool harness_check_eq(long actual, long expected, const char *actual_text, const char *expected_text, const char *file, int line) {
+    checks++;
+    if (actual != expected) {
+        failures++;
+        fprintf(stderr, "%s:%d: %s: %s is %ld (0x%lx), expected %s = %ld (0x%lx)\n", file, line, current_test, actual_text, actual, actual, expected_text, expected, expected);
+        return false;
+    }
+    return true;
+}
+
+int harness_done(const char *suite) {
+    printf("%s: %u checks, %u failed\n", suite, checks, failures);
+    return failures ? 1 : 0;
+}
+
+// ----------------------------------------------------------------------------
+// Measurements
+// ----------------------------------------------------------------------------
+
+uint64_t harness_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + now.tv_nsec;
+}
+
+uint64_t harness_cycles(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
@@ -0,0 +1,100 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+// Test harness for keymap.c on the host. A test includes keymap.c and
+// qmk/keymap_introspection.c, then drives the keymap one matrix scan at a
+// time: key events go through a stand-in for QMK's action pipeline (layer
+// lookup, process_record_user, basic keycodes), the scan ends with the RGB
+// matrix task, deferred execution and housekeeping_task_user, and every HID
+// report that reaches the host driver is logged with its scan number.
+
+#pragma once
+
+#include "qmk.h"
+
+// ----------------------------------------------------------------------------
+// Scans and key events
+// ----------------------------------------------------------------------------
+
+extern uint32_t harness_time;   // ms since boot, advanced by one per scan
+extern uint32_t harness_scans;  // completed scans
+
+// eeconfig_init_user, keyboard_post_init_user, OS detection, one scan
+void harness_boot(os_variant_t os);
+void harness_set_os(os_variant_t os);
+
+// One scan with several events: begin, any number of keys, end
+void harness_scan_begin(void);
+void harness_scan_key(keypos_t key, bool pressed);
+void harness_scan_end(void);
+
+// Matrix position of a keycode, searching the base layer first; aborts the
+// test if no layer has it
+keypos_t harness_key_pos(uint16_t keycode);
+keypos_t harness_key_pos_on(uint8_t layer, uint16_t keycode);
+
+// One scan with a single event at the position of keycode
+void key_press(uint16_t keycode);
+void key_release(uint16_t keycode);
+void key_tap(uint16_t keycode);
+
+// Scans without events
+void harness_idle(uint32_t ms);
+
+// ----------------------------------------------------------------------------
+// What the keymap did
+// ----------------------------------------------------------------------------
+
+enum harness_report_type { REPORT_KEYBOARD, REPORT_MOUSE, REPORT_EXTRA };
+
+typedef struct {
+    uint8_t  type;
+    uint32_t scan;
+    union {
+        report_keyboard_t keyboard;
+        report_mouse_t    mouse;
+        report_extra_t    extra;
+    };
+} harness_report_t;
+
+#define HARNESS_REPORT_LOG 1024
+
+extern harness_report_t harness_reports[HARNESS_REPORT_LOG];
+extern uint16_t         harness_report_count;    // logged since the last clear
+extern uint32_t         harness_report_dropped;  // sent after the log was full
+
+void                    harness_reports_clear(void);
+uint16_t                harness_count_reports(uint8_t type);
+const harness_report_t *harness_last_report(uint8_t type);
+
+// True if report holds exactly keycode: its modifiers and its basic key, or
+// nothing for KC_NO
+bool keyboard_report_is(const report_keyboard_t *report, uint16_t keycode);
+
+extern uint16_t harness_reentries;     // action_exec called from inside the pipeline
+extern uint16_t harness_wait_ms_calls; // blocking waits
+extern uint16_t harness_rgb_frames;    // frames rendered by the RGB matrix task
+extern uint16_t harness_rgb_dark_frames; // of those, black: disabled or timed out
+extern led_t    harness_leds;          // host LED state
+extern uint8_t  harness_raw_hid[RAW_EPSIZE];
+
+extern char     harness_console[4096];
+extern uint16_t harness_console_len;
+void            harness_console_clear(void);
+
+// ----------------------------------------------------------------------------
+// Checks and measurements
+// ----------------------------------------------------------------------------
+
+#define CHECK(cond) harness_check((cond), #cond, __FILE__, __LINE__)
+#define CHECK_EQ(actual, expected) harness_check_eq((long)(actual), (long)(expected), #actual, #expected, __FILE__, __LINE__)
+
+void harness_test(const char *name);
+bool harness_check(bool ok, const char *text, const char *file, int line);
+bool harness_check_eq(long actual, long expected, const char *actual_text, const char *expected_text, const char *file, int line);
+
+// Prints the summary line; returns the process exit status
+int harness_done(const char *suite);
+
+// Wall clock in ns and CPU cycles (0 where there is no cycle counter)
+uint64_t harness_ns(void);
+uint64_t harness_cycles(void);
@@ -0,0 +1,17 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+// Host stand-in for QMK's keymap_introspection.c. Like the original, it
+// needs keymaps[] in the same translation unit, so tests include it right
+// after keymap.c, and the weak defaults sit in that translation unit too: a
+// keymap that defines one of them again fails to compile, as it would in QMK.
+
+uint16_t keycode_at_keymap_location_raw(uint8_t layer, uint8_t row, uint8_t col) {
+    if (layer < ARRAY_SIZE(keymaps) && row < MATRIX_ROWS && col < MATRIX_COLS) {
+        return pgm_read_word(&keymaps[layer][row][col]);
+    }
+    return KC_TRNS;
+}
+
+__attribute__((weak)) uint16_t keycode_at_keymap_location(uint8_t layer, uint8_t row, uint8_t col) {
+    return keycode_at_keymap_location_raw(layer, row, col);
+}
@@ -0,0 +1,6 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+// Host stand-in for QMK's keymap_introspection.h. keycode_at_keymap_location_raw
+// is declared in qmk.h and defined next to keymaps[] by harness.h.
+
+#pragma once
@@ -0,0 +1,698 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+// Host implementation of the QMK APIs keymap.c uses, and the scan loop the
+// tests drive. It follows QMK closely where the keymap depends on it:
+//   - a press looks the key up from the highest active layer down and
+//     remembers that source layer; the release uses the remembered layer
+//   - post_process_record_user only runs when process_record_user returned
+//     true
+//   - keyboard and extrakey reports are only sent when they changed
+//   - a scan runs matrix_scan_user, the key events, the RGB matrix task,
+//     deferred execution, then housekeeping_task_user
+// Tap-hold keys are simplified: one-shot mods act as held modifiers, and a
+// release within the tapping term with no other key pressed is a tap.
+
+#include <stdarg.h>
+#include <stdio.h>
+
+#include "qmk.h"
+#include "rgb_matrix.h"
+#include "transactions.h"
+#include "harness.h"
+
+// ----------------------------------------------------------------------------
+// Timer, deferred execution
+// ----------------------------------------------------------------------------
+
+uint32_t harness_time;
+uint32_t harness_scans;
+
+static uint32_t last_matrix_activity;
+
+uint16_t timer_read(void) {
+    return (uint16_t)harness_time;
+}
+
+uint32_t timer_read32(void) {
+    return harness_time;
+}
+
+uint16_t timer_elapsed(uint16_t last) {
+    return TIMER_DIFF_16(timer_read(), last);
+}
+
+uint32_t timer_elapsed32(uint32_t last) {
+    return TIMER_DIFF_32(timer_read32(), last);
+}
+
+uint16_t harness_wait_ms_calls;
+
+void wait_ms(uint16_t ms) {
+    harness_wait_ms_calls++;
+    harness_time += ms;
+}
+
+uint32_t last_matrix_activity_elapsed(void) {
+    return timer_elapsed32(last_matrix_activity);
+}
+
+// No encoders or pointing devices: input activity is matrix activity
+uint32_t last_input_activity_elapsed(void) {
+    return last_matrix_activity_elapsed();
+}
+
+#define DEFERRED_SLOTS 8
+
+typedef struct {
+    deferred_exec_callback callback;
+    void                  *cb_arg;
+    uint32_t               trigger_time;
+} deferred_slot_t;
+
+static deferred_slot_t deferred[DEFERRED_SLOTS];
+
+deferred_token defer_exec(uint32_t delay_ms, deferred_exec_callback callback, void *cb_arg) {
+    if (!delay_ms || !callback) {
+        return INVALID_DEFERRED_TOKEN;
+    }
+    for (uint8_t i = 0; i < DEFERRED_SLOTS; i++) {
+        if (!deferred[i].callback) {
+            deferred[i] = (deferred_slot_t){ callback, cb_arg, harness_time + delay_ms };
+            return i + 1;
+        }
+    }
+    return INVALID_DEFERRED_TOKEN;
+}
+
+bool cancel_deferred_exec(deferred_token token) {
+    if (token == INVALID_DEFERRED_TOKEN || token > DEFERRED_SLOTS || !deferred[token - 1].callback) {
+        return false;
+    }
+    deferred[token - 1].callback = NULL;
+    return true;
+}
+
+static void deferred_exec_task(void) {
+    for (uint8_t i = 0; i < DEFERRED_SLOTS; i++) {
+        deferred_slot_t *slot = &deferred[i];
+        if (slot->callback && TIMER_DIFF_32(harness_time, slot->trigger_time) < UINT32_MAX / 2) {
+            uint32_t delay = slot->callback(slot->trigger_time, slot->cb_arg);
+            if (delay) {
+                slot->trigger_time = harness_time + delay;
+            } else {
+                slot->callback = NULL;
+            }
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Host driver and reports
+// ----------------------------------------------------------------------------
+
+harness_report_t harness_reports[HARNESS_REPORT_LOG];
+uint16_t         harness_report_count;
+uint32_t         harness_report_dropped;
+led_t            harness_leds;
+
+static harness_report_t *harness_log(uint8_t type) {
+    if (harness_report_count >= HARNESS_REPORT_LOG) {
+        harness_report_dropped++;
+        return NULL;
+    }
+    harness_report_t *entry = &harness_reports[harness_report_count++];
+    memset(entry, 0, sizeof(*entry));
+    entry->type = type;
+    entry->scan = harness_scans;
+    return entry;
+}
+
+static uint8_t driver_keyboard_leds(void) {
+    return harness_leds.raw;
+}
+
+static void driver_send_keyboard(report_keyboard_t *report) {
+    harness_report_t *entry = harness_log(REPORT_KEYBOARD);
+    if (entry) {
+        entry->keyboard = *report;
+    }
+}
+
+static void driver_send_mouse(report_mouse_t *report) {
+    harness_report_t *entry = harness_log(REPORT_MOUSE);
+    if (entry) {
+        entry->mouse = *report;
+    }
+}
+
+static void driver_send_extra(report_extra_t *report) {
+    harness_report_t *entry = harness_log(REPORT_EXTRA);
+    if (entry) {
+        entry->extra = *report;
+    }
+}
+
+static host_driver_t  harness_driver = {
+    .keyboard_leds = driver_keyboard_leds,
+    .send_keyboard = driver_send_keyboard,
+    .send_mouse    = driver_send_mouse,
+    .send_extra    = driver_send_extra,
+};
+static host_driver_t *host_driver = &harness_driver;
+
+host_driver_t *host_get_driver(void) {
+    return host_driver;
+}
+
+void host_set_driver(host_driver_t *driver) {
+    host_driver = driver;
+}
+
+led_t host_keyboard_led_state(void) {
+    return harness_leds;
+}
+
+void host_mouse_send(report_mouse_t *report) {
+    host_driver->send_mouse(report);
+}
+
+static void host_extra_send(uint8_t report_id, uint16_t usage, uint16_t *last_usage) {
+    if (usage == *last_usage) {
+        return;
+    }
+    *last_usage           = usage;
+    report_extra_t report = { .report_id = report_id, .usage = usage };
+    host_driver->send_extra(&report);
+}
+
+void host_system_send(uint16_t usage) {
+    static uint16_t last_usage;
+    host_extra_send(REPORT_ID_SYSTEM, usage, &last_usage);
+}
+
+void host_consumer_send(uint16_t usage) {
+    static uint16_t last_usage;
+    host_extra_send(REPORT_ID_CONSUMER, usage, &last_usage);
+}
+
+// ----------------------------------------------------------------------------
+// Keyboard report
+// ----------------------------------------------------------------------------
+
+static report_keyboard_t keyboard_report;
+static report_keyboard_t keyboard_last_sent;
+static uint8_t           real_mods;
+static uint8_t           weak_mods;
+
+uint8_t get_mods(void) {
+    return real_mods;
+}
+
+void add_mods(uint8_t mods) {
+    real_mods |= mods;
+}
+
+void del_mods(uint8_t mods) {
+    real_mods &= ~mods;
+}
+
+void send_keyboard_report(void) {
+    keyboard_report.mods = real_mods | weak_mods;
+    if (memcmp(&keyboard_report, &keyboard_last_sent, sizeof(keyboard_report)) != 0) {
+        keyboard_last_sent = keyboard_report;
+        host_driver->send_keyboard(&keyboard_report);
+    }
+}
+
+// 5-bit keycode modifiers to the 8-bit report mask
+static uint8_t mod_config_to_bits(uint8_t mods) {
+    return (mods & 0x10) ? (mods & 0x0F) << 4 : (mods & 0x0F);
+}
+
+static uint16_t consumer_usage(uint8_t kc) {
+    switch (kc) {
+        case KC_MUTE: return 0x00E2;
+        case KC_VOLU: return 0x00E9;
+        case KC_VOLD: return 0x00EA;
+        case KC_MNXT: return 0x00B5;
+        case KC_MPRV: return 0x00B6;
+        case KC_MSTP: return 0x00B7;
+        case KC_MPLY: return 0x00CD;
+        default:      return 0;
+    }
+}
+
+static uint16_t system_usage(uint8_t kc) {
+    return 0x0081 + (kc - KC_PWR);  // power down, sleep, wake up
+}
+
+static void keyboard_report_key(uint8_t kc, bool pressed) {
+    for (uint8_t i = 0; i < KEYBOARD_REPORT_KEYS; i++) {
+        if (keyboard_report.keys[i] == kc) {
+            if (!pressed) {
+                keyboard_report.keys[i] = 0;
+            }
+            return;
+        }
+    }
+    for (uint8_t i = 0; pressed && i < KEYBOARD_REPORT_KEYS; i++) {
+        if (!keyboard_report.keys[i]) {
+            keyboard_report.keys[i] = kc;
+            return;
+        }
+    }
+}
+
+static void mousekey_key(uint16_t keycode, bool pressed);
+
+static void register_key(uint8_t kc, bool pressed) {
+    if (kc == KC_NO) {
+        return;
+    }
+    if (kc >= KC_LCTL && kc <= KC_RGUI) {
+        if (pressed) {
+            add_mods(MOD_BIT(kc));
+        } else {
+            del_mods(MOD_BIT(kc));
+        }
+        send_keyboard_report();
+    } else if (kc >= KC_PWR && kc <= KC_WAKE) {
+        host_system_send(pressed ? system_usage(kc) : 0);
+    } else if (kc >= KC_MUTE && kc <= KC_MPLY) {
+        host_consumer_send(pressed ? consumer_usage(kc) : 0);
+    } else if (kc >= KC_A && kc < KC_PWR) {
+        keyboard_report_key(kc, pressed);
+        send_keyboard_report();
+    } else if (kc >= MS_UP && kc <= MS_ACL2) {
+        mousekey_key(kc, pressed);
+    }
+}
+
+void register_code(uint8_t kc) {
+    register_key(kc, true);
+}
+
+void unregister_code(uint8_t kc) {
+    register_key(kc, false);
+}
+
+// Like QMK: modifiers of a modified basic key are weak, those of a
+// modifier keycode are real
+void register_code16(uint16_t kc) {
+    uint8_t mods  = mod_config_to_bits(kc >> 8);
+    uint8_t basic = kc & 0xFF;
+    if (mods) {
+        if (basic == KC_NO || (basic >= KC_LCTL && basic <= KC_RGUI)) {
+            add_mods(mods);
+        } else {
+            weak_mods |= mods;
+        }
+        send_keyboard_report();
+    }
+    register_code(basic);
+}
+
+void unregister_code16(uint16_t kc) {
+    uint8_t mods  = mod_config_to_bits(kc >> 8);
+    uint8_t basic = kc & 0xFF;
+    unregister_code(basic);
+    if (mods) {
+        if (basic == KC_NO || (basic >= KC_LCTL && basic <= KC_RGUI)) {
+            del_mods(mods);
+        } else {
+            weak_mods &= ~mods;
+        }
+        send_keyboard_report();
+    }
+}
+
+void tap_code16(uint16_t kc) {
+    register_code16(kc);
+    unregister_code16(kc);
+}
+
+// ----------------------------------------------------------------------------
+// Mousekeys
+// ----------------------------------------------------------------------------
+
+static report_mouse_t mouse_report;
+
+report_mouse_t mousekey_get_report(void) {
+    return mouse_report;
+}
+
+// One step per press; the keymap's own engines replace this when enabled
+static void mousekey_key(uint16_t keycode, bool pressed) {
+    report_mouse_t report = mouse_report;
+    if (keycode >= MS_BTN1 && keycode <= MS_BTN8) {
+        uint8_t bit = 1 << (keycode - MS_BTN1);
+        mouse_report.buttons = pressed ? (mouse_report.buttons | bit) : (mouse_report.buttons & ~bit);
+        report.buttons       = mouse_report.buttons;
+    } else if (!pressed) {
+        return;
+    } else {
+        switch (keycode) {
+            case MS_UP:   report.y = -1; break;
+            case MS_DOWN: report.y = 1;  break;
+            case MS_LEFT: report.x = -1; break;
+            case MS_RGHT: report.x = 1;  break;
+            case MS_WHLU: report.v = 1;  break;
+            case MS_WHLD: report.v = -1; break;
+            case MS_WHLL: report.h = -1; break;
+            case MS_WHLR: report.h = 1;  break;
+            default:      return;
+        }
+    }
+    host_mouse_send(&report);
+}
+
+// ----------------------------------------------------------------------------
+// Layers
+// ----------------------------------------------------------------------------
+
+layer_state_t layer_state;
+layer_state_t default_layer_state = 1;
+
+__attribute__((weak)) layer_state_t layer_state_set_user(layer_state_t state) {
+    return state;
+}
+
+void layer_state_set(layer_state_t state) {
+    layer_state = layer_state_set_user(state);
+}
+
+void layer_on(uint8_t layer) {
+    layer_state_set(layer_state | ((layer_state_t)1 << layer));
+}
+
+void layer_off(uint8_t layer) {
+    layer_state_set(layer_state & ~((layer_state_t)1 << layer));
+}
+
+uint8_t get_highest_layer(layer_state_t state) {
+    return state ? 31 - __builtin_clz(state) : 0;
+}
+
+void set_single_persistent_default_layer(uint8_t layer) {
+    default_layer_state = (layer_state_t)1 << layer;
+}
+
+// ----------------------------------------------------------------------------
+// Action pipeline
+// ----------------------------------------------------------------------------
+
+uint16_t harness_reentries;
+
+static uint8_t  source_layers[MATRIX_ROWS][MATRIX_COLS];
+static uint16_t pressed_at[MATRIX_ROWS][MATRIX_COLS];
+static uint32_t presses;
+static uint32_t pressed_after[MATRIX_ROWS][MATRIX_COLS];
+static bool     in_action;
+
+__attribute__((weak)) void post_process_record_user(uint16_t keycode, keyrecord_t *record) {}
+
+__attribute__((weak)) uint16_t get_tapping_term(uint16_t keycode, keyrecord_t *record) {
+    return TAPPING_TERM;
+}
+
+static uint16_t tapping_term(uint16_t keycode, keyrecord_t *record) {
+#ifdef TAPPING_TERM_PER_KEY
+    return get_tapping_term(keycode, record);
+#else
+    return TAPPING_TERM;
+#endif
+}
+
+static uint8_t layer_switch_get_layer(keypos_t key) {
+    layer_state_t layers = layer_state | default_layer_state;
+    for (int8_t i = 31; i >= 0; i--) {
+        if ((layers & ((layer_state_t)1 << i)) && keycode_at_keymap_location(i, key.row, key.col) != KC_TRNS) {
+            return i;
+        }
+    }
+    return 0;
+}
+
+static void process_action(uint16_t keycode, keyrecord_t *record) {
+    bool pressed = record->event.pressed;
+
+    if (IS_QK_MOMENTARY(keycode)) {
+        if (pressed) {
+            layer_on(keycode & 0x1F);
+        } else {
+            layer_off(keycode & 0x1F);
+        }
+    } else if (IS_QK_ONE_SHOT_MOD(keycode)) {
+        uint8_t mods = mod_config_to_bits(keycode & 0x1F);
+        if (pressed) {
+            add_mods(mods);
+        } else {
+            del_mods(mods);
+        }
+        send_keyboard_report();
+    } else if (keycode >= MS_UP && keycode <= MS_ACL2) {
+        mousekey_key(keycode, pressed);
+    } else if (keycode <= QK_MODS_MAX) {
+        if (pressed) {
+            register_code16(keycode);
+        } else {
+            unregister_code16(keycode);
+        }
+    }
+    // RGB, bootloader and other quantum keycodes do nothing on the host
+}
+
+void action_exec(keyevent_t event) {
+    bool outer = in_action;
+    if (outer) {
+        harness_reentries++;
+    }
+    in_action = true;
+
+    keypos_t    key    = event.key;
+    keyrecord_t record = { .event = event };
+    uint8_t     layer;
+
+    if (event.pressed) {
+        layer                             = layer_switch_get_layer(key);
+        source_layers[key.row][key.col]   = layer;
+        pressed_at[key.row][key.col]      = event.time;
+        pressed_after[key.row][key.col]   = ++presses;
+    } else {
+        layer = source_layers[key.row][key.col];
+    }
+    uint16_t keycode = keycode_at_keymap_location(layer, key.row, key.col);
+    record.keycode   = keycode;
+
+    if (!event.pressed && (IS_QK_MOD_TAP(keycode) || IS_QK_LAYER_TAP(keycode) || IS_QK_ONE_SHOT_MOD(keycode))) {
+        bool interrupted      = presses != pressed_after[key.row][key.col];
+        record.tap.interrupted = interrupted;
+        record.tap.count       = !interrupted && TIMER_DIFF_16(event.time, pressed_at[key.row][key.col]) < tapping_term(keycode, &record);
+    }
+
+    if (process_record_user(keycode, &record)) {
+        process_action(keycode, &record);
+        post_process_record_user(keycode, &record);
+    }
+    in_action = outer;
+}
+
+// ----------------------------------------------------------------------------
+// EEPROM
+// ----------------------------------------------------------------------------
+
+static uint32_t eeprom_user;
+static uint8_t  eeprom_datablock[64];
+
+uint32_t eeconfig_read_user(void) {
+    return eeprom_user;
+}
+
+void eeconfig_update_user(uint32_t value) {
+    eeprom_user = value;
+}
+
+void eeconfig_read_user_datablock(void *data, uint32_t offset, uint32_t length) {
+    if (offset + length <= sizeof(eeprom_datablock)) {
+        memcpy(data, &eeprom_datablock[offset], length);
+    }
+}
+
+void eeconfig_update_user_datablock(const void *data, uint32_t offset, uint32_t length) {
+    if (offset + length <= sizeof(eeprom_datablock)) {
+        memcpy(&eeprom_datablock[offset], data, length);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// RGB matrix
+// ----------------------------------------------------------------------------
+
+#ifndef RGB_MATRIX_LED_FLUSH_LIMIT
+    #define RGB_MATRIX_LED_FLUSH_LIMIT 16
+#endif
+
+uint16_t     harness_rgb_frames;
+uint16_t     harness_rgb_dark_frames;
+led_config_t g_led_config;
+
+static hsv_t    rgb_hsv     = { 0, 255, 255 };
+static bool     rgb_enabled = true;
+static uint16_t rgb_flush_timer;
+
+rgb_t hsv_to_rgb(hsv_t hsv) {
+    return (rgb_t){ hsv.v, hsv.v, hsv.v };
+}
+
+hsv_t rgb_matrix_get_hsv(void) {
+    return rgb_hsv;
+}
+
+uint8_t rgb_matrix_get_val(void) {
+    return rgb_hsv.v;
+}
+
+void rgb_matrix_sethsv_noeeprom(uint8_t hue, uint8_t sat, uint8_t val) {
+    rgb_hsv = (hsv_t){ hue, sat, val };
+}
+
+void rgb_matrix_set_color(int index, uint8_t red, uint8_t green, uint8_t blue) {}
+
+bool rgb_matrix_is_enabled(void) {
+    return rgb_enabled;
+}
+
+void rgb_matrix_enable_noeeprom(void) {
+    rgb_enabled = true;
+}
+
+void rgb_matrix_disable_noeeprom(void) {
+    rgb_enabled = false;
+}
+
+__attribute__((weak)) bool rgb_matrix_indicators_advanced_user(uint8_t led_min, uint8_t led_max) {
+    return false;
+}
+
+// Renders and flushes a frame once RGB_MATRIX_LED_FLUSH_LIMIT ms have passed;
+// QMK compares against a 16-bit timer as well. Like QMK, it keeps flushing
+// while disabled or past RGB_MATRIX_TIMEOUT, black and without indicators.
+static void rgb_matrix_task(void) {
+    if (timer_elapsed(rgb_flush_timer) < RGB_MATRIX_LED_FLUSH_LIMIT) {
+        return;
+    }
+    rgb_flush_timer = timer_read();
+    harness_rgb_frames++;
+
+    bool dark = !rgb_enabled;
+#if RGB_MATRIX_TIMEOUT > 0
+    dark = dark || last_input_activity_elapsed() > (uint32_t)RGB_MATRIX_TIMEOUT;
+#endif
+    if (dark) {
+        harness_rgb_dark_frames++;
+        return;
+    }
+    rgb_matrix_indicators_advanced_user(0, RGB_MATRIX_LED_COUNT);
+}
+
+// ----------------------------------------------------------------------------
+// Split, raw HID, console
+// ----------------------------------------------------------------------------
+
+bool is_keyboard_master(void) {
+    return true;
+}
+
+void transaction_register_rpc(int8_t transaction_id, slave_callback_t callback) {}
+
+bool transaction_rpc_send(int8_t transaction_id, uint8_t initiator2target_buflen, const void *initiator2target_buf) {
+    return true;
+}
+
+uint8_t harness_raw_hid[RAW_EPSIZE];
+
+void raw_hid_send(uint8_t *data, uint8_t length) {
+    memcpy(harness_raw_hid, data, length < RAW_EPSIZE ? length : RAW_EPSIZE);
+}
+
+char     harness_console[4096];
+uint16_t harness_console_len;
+
+void harness_console_clear(void) {
+    harness_console_len = 0;
+    harness_console[0]  = '\0';
+}
+
+int8_t sendchar(uint8_t c) {
+    if ((size_t)harness_console_len + 1 < sizeof(harness_console)) {
+        harness_console[harness_console_len++] = c;
+        harness_console[harness_console_len]   = '\0';
+    }
+    return 0;
+}
+
+int uprintf(const char *format, ...) {
+    char    line[256];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+    for (const char *c = line; *c; c++) {
+        sendchar(*c);
+    }
+    return length;
+}
+
+// ----------------------------------------------------------------------------
+// Callbacks the keymap may leave out
+// ----------------------------------------------------------------------------
+
+__attribute__((weak)) void matrix_scan_user(void) {}
+__attribute__((weak)) void housekeeping_task_user(void) {}
+__attribute__((weak)) void keyboard_post_init_user(void) {}
+__attribute__((weak)) void eeconfig_init_user(void) {}
+__attribute__((weak)) bool led_update_user(led_t led_state) {
+    return true;
+}
+__attribute__((weak)) bool process_detected_host_os_user(os_variant_t detected_os) {
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// Scan loop
+// ----------------------------------------------------------------------------
+
+void harness_boot(os_variant_t os) {
+    eeconfig_init_user();
+    keyboard_post_init_user();
+    harness_set_os(os);
+    harness_idle(1);
+}
+
+void harness_set_os(os_variant_t os) {
+    process_detected_host_os_user(os);
+}
+
+void harness_scan_begin(void) {
+    matrix_scan_user();
+}
+
+void harness_scan_key(keypos_t key, bool pressed) {
+    last_matrix_activity = harness_time;
+    action_exec((keyevent_t){ .key = key, .pressed = pressed, .time = timer_read(), .type = 1 });
+}
+
+void harness_scan_end(void) {
+    rgb_matrix_task();
+    deferred_exec_task();
+    housekeeping_task_user();
+    harness_scans++;
+    harness_time++;
+}
+
+void harness_idle(uint32_t ms) {
+    while (ms--) {
+        harness_scan_begin();
+        harness_scan_end();
+    }
+}
@@ -0,0 +1,336 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+// Host stand-in for QMK_KEYBOARD_H: the keycodes, types and APIs keymap.c
+// uses, with the keebio/iris/rev7 matrix. Values follow QMK where keymap.c
+// or the tests depend on them (keycode ranges, modifier encoding, report
+// IDs); everything is implemented in qmk.c.
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PROGMEM
+#define pgm_read_byte(p) (*(const uint8_t *)(p))
+#define pgm_read_word(p) (*(const uint16_t *)(p))
+#define memcpy_P memcpy
+
+#define ARRAY_SIZE(a) (sizeof(a) / sizeof(*(a)))
+
+// ----------------------------------------------------------------------------
+// Matrix and layout
+// ----------------------------------------------------------------------------
+
+#define MATRIX_ROWS 10
+#define MATRIX_COLS 6
+
+typedef uint8_t matrix_row_t;
+#define MATRIX_ROW_SHIFTER ((matrix_row_t)1)
+
+// Left half on rows 0-4, right half on rows 5-9 with column 0 outermost;
+// the inner key next to the bottom row shares the thumb row
+#define LAYOUT( \
+    LA1, LA2, LA3, LA4, LA5, LA6,           RA6, RA5, RA4, RA3, RA2, RA1, \
+    LB1, LB2, LB3, LB4, LB5, LB6,           RB6, RB5, RB4, RB3, RB2, RB1, \
+    LC1, LC2, LC3, LC4, LC5, LC6,           RC6, RC5, RC4, RC3, RC2, RC1, \
+    LD1, LD2, LD3, LD4, LD5, LD6, LE1, RE1, RD6, RD5, RD4, RD3, RD2, RD1, \
+                   LE2, LE3, LE4,           RE4, RE3, RE2 \
+) { \
+    { LA1, LA2, LA3, LA4, LA5, LA6 }, \
+    { LB1, LB2, LB3, LB4, LB5, LB6 }, \
+    { LC1, LC2, LC3, LC4, LC5, LC6 }, \
+    { LD1, LD2, LD3, LD4, LD5, LD6 }, \
+    { KC_NO, KC_NO, LE2, LE3, LE4, LE1 }, \
+    { RA1, RA2, RA3, RA4, RA5, RA6 }, \
+    { RB1, RB2, RB3, RB4, RB5, RB6 }, \
+    { RC1, RC2, RC3, RC4, RC5, RC6 }, \
+    { RD1, RD2, RD3, RD4, RD5, RD6 }, \
+    { KC_NO, KC_NO, RE2, RE3, RE4, RE1 } \
+}
+
+// ----------------------------------------------------------------------------
+// Keycodes
+// ----------------------------------------------------------------------------
+
+enum qk_keycodes {
+    KC_NO = 0x0000,
+    KC_TRNS,
+    KC_A = 0x0004, KC_B, KC_C, KC_D, KC_E, KC_F, KC_G, KC_H, KC_I, KC_J, KC_K, KC_L, KC_M,
+    KC_N, KC_O, KC_P, KC_Q, KC_R, KC_S, KC_T, KC_U, KC_V, KC_W, KC_X, KC_Y, KC_Z,
+    KC_1, KC_2, KC_3, KC_4, KC_5, KC_6, KC_7, KC_8, KC_9, KC_0,
+    KC_ENT, KC_ESC, KC_BSPC, KC_TAB, KC_SPC, KC_MINS, KC_EQL, KC_LBRC, KC_RBRC, KC_BSLS,
+    KC_NUHS, KC_SCLN, KC_QUOT, KC_GRV, KC_COMM, KC_DOT, KC_SLSH, KC_CAPS,
+    KC_F1, KC_F2, KC_F3, KC_F4, KC_F5, KC_F6, KC_F7, KC_F8, KC_F9, KC_F10, KC_F11, KC_F12,
+    KC_PSCR, KC_SCRL, KC_PAUS, KC_INS, KC_HOME, KC_PGUP, KC_DEL, KC_END, KC_PGDN,
+    KC_RGHT, KC_LEFT, KC_DOWN, KC_UP,
+    KC_P1 = 0x0059, KC_P2, KC_P3, KC_P4, KC_P5, KC_P6, KC_P7, KC_P8, KC_P9, KC_P0,
+    KC_PWR = 0x00A5, KC_SLEP, KC_WAKE,
+    KC_MUTE = 0x00A8, KC_VOLU, KC_VOLD, KC_MNXT, KC_MPRV, KC_MSTP, KC_MPLY,
+    MS_UP = 0x00CD, MS_DOWN, MS_LEFT, MS_RGHT,
+    MS_BTN1, MS_BTN2, MS_BTN3, MS_BTN4, MS_BTN5, MS_BTN6, MS_BTN7, MS_BTN8,
+    MS_WHLU, MS_WHLD, MS_WHLL, MS_WHLR, MS_ACL0, MS_ACL1, MS_ACL2,
+    KC_LCTL = 0x00E0, KC_LSFT, KC_LALT, KC_LGUI, KC_RCTL, KC_RSFT, KC_RALT, KC_RGUI,
+    QK_MODS = 0x0100,
+    QK_MODS_MAX = 0x1FFF,
+    QK_MOD_TAP = 0x2000,
+    QK_MOD_TAP_MAX = 0x3FFF,
+    QK_LAYER_TAP = 0x4000,
+    QK_LAYER_TAP_MAX = 0x4FFF,
+    QK_MOMENTARY = 0x5220,
+    QK_MOMENTARY_MAX = 0x523F,
+    QK_ONE_SHOT_MOD = 0x52A0,
+    QK_ONE_SHOT_MOD_MAX = 0x52BF,
+    RM_TOGG = 0x7840, RM_NEXT, RM_PREV, RM_HUEU, RM_HUED, RM_SATU, RM_SATD, RM_VALU, RM_VALD,
+    RM_SPDU, RM_SPDD,
+    BL_STEP = 0x7805,
+    QK_BOOT = 0x7C00,
+    SAFE_RANGE = 0x7E40,
+};
+
+#define _______ KC_TRNS
+#define XXXXXXX KC_NO
+
+#define QK_LCTL 0x0100
+#define QK_LSFT 0x0200
+#define QK_LALT 0x0400
+#define QK_LGUI 0x0800
+#define QK_RMODS_MIN 0x1000
+
+#define LCTL(kc) (QK_LCTL | (kc))
+#define LSFT(kc) (QK_LSFT | (kc))
+#define LALT(kc) (QK_LALT | (kc))
+#define LGUI(kc) (QK_LGUI | (kc))
+#define LSG(kc) (QK_LGUI | QK_LSFT | (kc))
+#define C(kc) LCTL(kc)
+#define S(kc) LSFT(kc)
+#define A(kc) LALT(kc)
+#define G(kc) LGUI(kc)
+
+#define KC_TILD S(KC_GRV)
+#define KC_EXLM S(KC_1)
+#define KC_AT   S(KC_2)
+#define KC_HASH S(KC_3)
+#define KC_DLR  S(KC_4)
+#define KC_PERC S(KC_5)
+#define KC_CIRC S(KC_6)
+#define KC_AMPR S(KC_7)
+#define KC_ASTR S(KC_8)
+#define KC_LPRN S(KC_9)
+#define KC_RPRN S(KC_0)
+#define KC_UNDS S(KC_MINS)
+#define KC_PLUS S(KC_EQL)
+#define KC_LCBR S(KC_LBRC)
+#define KC_RCBR S(KC_RBRC)
+#define KC_PIPE S(KC_BSLS)
+#define KC_GT   S(KC_DOT)
+
+// 5-bit modifier encoding used in keycodes
+#define MOD_LCTL 0x01
+#define MOD_LSFT 0x02
+#define MOD_LALT 0x04
+#define MOD_LGUI 0x08
+#define MOD_RCTL 0x11
+#define MOD_RSFT 0x12
+#define MOD_RALT 0x14
+#define MOD_RGUI 0x18
+
+// 8-bit modifier mask of HID reports and get_mods()
+#define MOD_BIT(kc) (1 << ((kc) & 0x07))
+#define MOD_MASK_CTRL  (MOD_BIT(KC_LCTL) | MOD_BIT(KC_RCTL))
+#define MOD_MASK_SHIFT (MOD_BIT(KC_LSFT) | MOD_BIT(KC_RSFT))
+#define MOD_MASK_ALT   (MOD_BIT(KC_LALT) | MOD_BIT(KC_RALT))
+#define MOD_MASK_GUI   (MOD_BIT(KC_LGUI) | MOD_BIT(KC_RGUI))
+
+#define MO(layer) (QK_MOMENTARY | ((layer) & 0x1F))
+#define OSM(mod)  (QK_ONE_SHOT_MOD | ((mod) & 0x1F))
+
+#define IS_QK_MODS(kc)         ((kc) >= QK_MODS && (kc) <= QK_MODS_MAX)
+#define IS_QK_MOD_TAP(kc)      ((kc) >= QK_MOD_TAP && (kc) <= QK_MOD_TAP_MAX)
+#define IS_QK_LAYER_TAP(kc)    ((kc) >= QK_LAYER_TAP && (kc) <= QK_LAYER_TAP_MAX)
+#define IS_QK_MOMENTARY(kc)    ((kc) >= QK_MOMENTARY && (kc) <= QK_MOMENTARY_MAX)
+#define IS_QK_ONE_SHOT_MOD(kc) ((kc) >= QK_ONE_SHOT_MOD && (kc) <= QK_ONE_SHOT_MOD_MAX)
+
+#ifndef TAPPING_TERM
+    #define TAPPING_TERM 200
+#endif
+
+// ----------------------------------------------------------------------------
+// Actions and layers
+// ----------------------------------------------------------------------------
+
+typedef uint32_t layer_state_t;
+
+typedef struct {
+    uint8_t col;
+    uint8_t row;
+} keypos_t;
+
+typedef struct {
+    keypos_t key;
+    bool     pressed;
+    uint16_t time;
+    uint8_t  type;
+} keyevent_t;
+
+typedef struct {
+    bool    interrupted : 1;
+    bool    reserved2 : 1;
+    bool    reserved1 : 1;
+    bool    reserved0 : 1;
+    uint8_t count : 4;
+} tap_t;
+
+typedef struct {
+    keyevent_t event;
+    tap_t      tap;
+    uint16_t   keycode;
+} keyrecord_t;
+
+extern layer_state_t layer_state;
+extern layer_state_t default_layer_state;
+
+void          layer_on(uint8_t layer);
+void          layer_off(uint8_t layer);
+void          layer_state_set(layer_state_t state);
+uint8_t       get_highest_layer(layer_state_t state);
+void          set_single_persistent_default_layer(uint8_t layer);
+void          action_exec(keyevent_t event);
+
+uint16_t keycode_at_keymap_location_raw(uint8_t layer, uint8_t row, uint8_t col);
+uint16_t keycode_at_keymap_location(uint8_t layer, uint8_t row, uint8_t col);
+
+void    register_code(uint8_t kc);
+void    unregister_code(uint8_t kc);
+void    register_code16(uint16_t kc);
+void    unregister_code16(uint16_t kc);
+void    tap_code16(uint16_t kc);
+uint8_t get_mods(void);
+void    add_mods(uint8_t mods);
+void    del_mods(uint8_t mods);
+void    send_keyboard_report(void);
+
+// User callbacks; the keymap defines the ones it needs
+bool          process_record_user(uint16_t keycode, keyrecord_t *record);
+void          post_process_record_user(uint16_t keycode, keyrecord_t *record);
+void          matrix_scan_user(void);
+void          housekeeping_task_user(void);
+void          keyboard_post_init_user(void);
+void          eeconfig_init_user(void);
+layer_state_t layer_state_set_user(layer_state_t state);
+uint16_t      get_tapping_term(uint16_t keycode, keyrecord_t *record);
+
+// ----------------------------------------------------------------------------
+// Timer, deferred execution
+// ----------------------------------------------------------------------------
+
+#define TIMER_DIFF_16(a, b) ((uint16_t)((a) - (b)))
+#define TIMER_DIFF_32(a, b) ((uint32_t)((a) - (b)))
+
+uint16_t timer_read(void);
+uint32_t timer_read32(void);
+uint16_t timer_elapsed(uint16_t last);
+uint32_t timer_elapsed32(uint32_t last);
+void     wait_ms(uint16_t ms);
+
+uint32_t last_matrix_activity_elapsed(void);
+uint32_t last_input_activity_elapsed(void);
+
+typedef uint8_t deferred_token;
+#define INVALID_DEFERRED_TOKEN 0
+typedef uint32_t (*deferred_exec_callback)(uint32_t trigger_time, void *cb_arg);
+
+deferred_token defer_exec(uint32_t delay_ms, deferred_exec_callback callback, void *cb_arg);
+bool           cancel_deferred_exec(deferred_token token);
+
+// ----------------------------------------------------------------------------
+// Host reports
+// ----------------------------------------------------------------------------
+
+#define KEYBOARD_REPORT_KEYS 6
+
+enum report_id {
+    REPORT_ID_KEYBOARD = 1,
+    REPORT_ID_MOUSE,
+    REPORT_ID_SYSTEM,
+    REPORT_ID_CONSUMER,
+};
+
+typedef struct {
+    uint8_t mods;
+    uint8_t reserved;
+    uint8_t keys[KEYBOARD_REPORT_KEYS];
+} report_keyboard_t;
+
+typedef struct {
+    uint8_t buttons;
+    int8_t  x;
+    int8_t  y;
+    int8_t  v;
+    int8_t  h;
+} report_mouse_t;
+
+typedef struct __attribute__((packed)) {
+    uint8_t  report_id;
+    uint16_t usage;
+} report_extra_t;
+
+typedef struct {
+    uint8_t (*keyboard_leds)(void);
+    void (*send_keyboard)(report_keyboard_t *report);
+    void (*send_nkro)(void *report);
+    void (*send_mouse)(report_mouse_t *report);
+    void (*send_extra)(report_extra_t *report);
+} host_driver_t;
+
+host_driver_t *host_get_driver(void);
+void           host_set_driver(host_driver_t *driver);
+void           host_mouse_send(report_mouse_t *report);
+void           host_system_send(uint16_t usage);
+void           host_consumer_send(uint16_t usage);
+
+report_mouse_t mousekey_get_report(void);
+
+typedef union {
+    uint8_t raw;
+    struct {
+        bool num_lock : 1;
+        bool caps_lock : 1;
+        bool scroll_lock : 1;
+        bool compose : 1;
+        bool kana : 1;
+    };
+} led_t;
+
+led_t host_keyboard_led_state(void);
+bool  led_update_user(led_t led_state);
+
+// ----------------------------------------------------------------------------
+// OS detection, EEPROM, split, raw HID, console
+// ----------------------------------------------------------------------------
+
+typedef enum {
+    OS_UNSURE,
+    OS_LINUX,
+    OS_WINDOWS,
+    OS_MACOS,
+    OS_IOS,
+} os_variant_t;
+
+bool process_detected_host_os_user(os_variant_t detected_os);
+
+uint32_t eeconfig_read_user(void);
+void     eeconfig_update_user(uint32_t value);
+void     eeconfig_read_user_datablock(void *data, uint32_t offset, uint32_t length);
+void     eeconfig_update_user_datablock(const void *data, uint32_t offset, uint32_t length);
+
+bool is_keyboard_master(void);
+
+#define RAW_EPSIZE 32
+void raw_hid_send(uint8_t *data, uint8_t length);
+void raw_hid_receive(uint8_t *data, uint8_t length);
+
+int8_t sendchar(uint8_t c);
+int    uprintf(const char *format, ...) __attribute__((format(printf, 1, 2)));
@@ -0,0 +1,47 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+// Host stand-in for QMK's rgb_matrix.h; implemented in qmk.c
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define RGB_MATRIX_LED_COUNT 68
+#define NO_LED 255
+
+typedef struct {
+    uint8_t h;
+    uint8_t s;
+    uint8_t v;
+} hsv_t;
+
+typedef struct {
+    uint8_t r;
+    uint8_t g;
+    uint8_t b;
+} rgb_t;
+
+typedef struct {
+    uint8_t x;
+    uint8_t y;
+} led_point_t;
+
+typedef struct {
+    uint8_t     matrix_co[MATRIX_ROWS][MATRIX_COLS];
+    led_point_t point[RGB_MATRIX_LED_COUNT];
+    uint8_t     flags[RGB_MATRIX_LED_COUNT];
+} led_config_t;
+
+extern led_config_t g_led_config;
+
+rgb_t   hsv_to_rgb(hsv_t hsv);
+hsv_t   rgb_matrix_get_hsv(void);
+uint8_t rgb_matrix_get_val(void);
+void    rgb_matrix_sethsv_noeeprom(uint8_t hue, uint8_t sat, uint8_t val);
+void    rgb_matrix_set_color(int index, uint8_t red, uint8_t green, uint8_t blue);
+bool    rgb_matrix_is_enabled(void);
+void    rgb_matrix_enable_noeeprom(void);
+void    rgb_matrix_disable_noeeprom(void);
+
+bool rgb_matrix_indicators_advanced_user(uint8_t led_min, uint8_t led_max);
@@ -0,0 +1,20 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+// Host stand-in for QMK's split transactions; implemented in qmk.c
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+enum serial_transaction_id {
+#ifdef SPLIT_TRANSACTION_IDS_USER
+    SPLIT_TRANSACTION_IDS_USER,
+#endif
+    NUM_TOTAL_TRANSACTIONS
+};
+
+typedef void (*slave_callback_t)(uint8_t in_buflen, const void *in_data, uint8_t out_buflen, void *out_data);
+
+void transaction_register_rpc(int8_t transaction_id, slave_callback_t callback);
+bool transaction_rpc_send(int8_t transaction_id, uint8_t initiator2target_buflen, const void *initiator2target_buf);
@@ -0,0 +1,82 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+// Adaptive tapping term: clean taps pull the term down, lone holds that only
+// just missed it push it back up, and real holds leave it alone.
+
+#include <stdio.h>
+
+#include "keymap.c"
+#include "keymap_introspection.c"
+
+#include "harness.h"
+
+#ifdef ADAPTIVE_TERM_ENABLE
+
+static uint16_t term(void) {
+    return get_tapping_term(KC_AG, NULL);
+}
+
+static void hold(uint16_t ms) {
+    key_press(KC_AG);
+    harness_idle(ms - 1);
+    key_release(KC_AG);
+    harness_idle(200);
+}
+
+static void test_taps(void) {
+    harness_test("adaptive term taps");
+    CHECK_EQ(term(), TAPPING_TERM);
+
+    for (uint8_t i = 0; i < 20; i++) {
+        hold(90);
+    }
+    CHECK(term() >= ADAPTIVE_TERM_MIN && term() < TAPPING_TERM);
+}
+
+static void test_misfires(void) {
+    harness_test("adaptive term misfires");
+
+    // Taps that came a little too late, one after the other
+    uint16_t before = term();
+    uint16_t late   = before + 30;
+    hold(late);
+    CHECK(term() > before);
+    for (uint8_t i = 0; i < 3 && term() <= late; i++) {
+        hold(late);
+    }
+    CHECK(term() > late);
+}
+
+static void test_holds(void) {
+    harness_test("adaptive term holds");
+    uint16_t before = term();
+
+    // Long holds, and holds used as a modifier
+    hold(before + ADAPTIVE_TERM_MISFIRE_WINDOW + 50);
+    CHECK_EQ(term(), before);
+
+    key_press(KC_AG);
+    harness_idle(20);
+    key_tap(KC_A);
+    harness_idle(before);
+    key_release(KC_AG);
+    harness_idle(200);
+    CHECK_EQ(term(), before);
+}
+
+int main(void) {
+    harness_boot(OS_MACOS);
+    test_taps();
+    test_misfires();
+    test_holds();
+    return harness_done("test_adaptive_term");
+}
+
+#else
+
+int main(void) {
+    printf("test_adaptive_term: skipped, ADAPTIVE_TERM_ENABLE is off\n");
+    return 0;
+}
+
+#endif
@@ -0,0 +1,249 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+// OS action chords: a chord fires as soon as its keys are down, chord keys
+// that do not make a chord reach the host in the order they were pressed,
+// rolled typing never fires one, and held-back keys are replayed from
+// housekeeping, never from inside the action pipeline.
+
+#include <stdio.h>
+
+#include "keymap.c"
+#include "keymap_introspection.c"
+
+#include "harness.h"
+
+#ifdef OS_CHORD_ENABLE
+
+// Scan of the first keyboard report since the last clear with the basic key
+// of keycode down, or UINT32_MAX
+static uint32_t scan_down(uint16_t keycode) {
+    for (uint16_t i = 0; i < harness_report_count; i++) {
+        const harness_report_t *r = &harness_reports[i];
+        if (r->type != REPORT_KEYBOARD) {
+            continue;
+        }
+        for (uint8_t k = 0; k < ARRAY_SIZE(r->keyboard.keys); k++) {
+            if (r->keyboard.keys[k] == (keycode & 0xFF)) {
+                return r->scan;
+            }
+        }
+        if (keycode >= KC_LCTL && keycode <= KC_RGUI && (r->keyboard.mods & MOD_BIT(keycode))) {
+            return r->scan;
+        }
+    }
+    return UINT32_MAX;
+}
+
+// Where the basic key of keycode first went down: report index, then slot
+// in that report, since coalesced presses share one report; UINT16_MAX if
+// it never did
+static uint16_t key_order(uint16_t keycode) {
+    for (uint16_t i = 0; i < harness_report_count; i++) {
+        const harness_report_t *r = &harness_reports[i];
+        for (uint8_t k = 0; r->type == REPORT_KEYBOARD && k < ARRAY_SIZE(r->keyboard.keys); k++) {
+            if (r->keyboard.keys[k] == keycode) {
+                return i * KEYBOARD_REPORT_KEYS + k;
+            }
+        }
+    }
+    return UINT16_MAX;
+}
+
+// True if every keyboard report since the last clear held nothing but parts
+// of keycode
+static bool reports_within(uint16_t keycode) {
+    uint8_t basic = keycode & 0xFF;
+    uint8_t mods  = (keycode >> 8) & 0x1F;
+    mods          = (mods & 0x10) ? (mods & 0x0F) << 4 : mods;
+
+    for (uint16_t i = 0; i < harness_report_count; i++) {
+        const harness_report_t *r = &harness_reports[i];
+        if (r->type != REPORT_KEYBOARD) {
+            continue;
+        }
+        if (r->keyboard.mods & ~mods) {
+            return false;
+        }
+        for (uint8_t k = 0; k < ARRAY_SIZE(r->keyboard.keys); k++) {
+            if (r->keyboard.keys[k] && r->keyboard.keys[k] != basic) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static bool released_all(void) {
+    return keyboard_report_is(&harness_last_report(REPORT_KEYBOARD)->keyboard, KC_NO);
+}
+
+static void test_fire(void) {
+    static const struct {
+        uint16_t key1, key2, sends;
+    } chords[] = {
+        { KC_ESC, KC_TAB, C(KC_SPC) },
+        { KC_SCLN, KC_SLSH, LSG(KC_4) },
+        { KC_DEL, KC_QUOT, LSG(C(KC_4)) },
+    };
+
+    harness_test("chord fires");
+    for (uint8_t i = 0; i < ARRAY_SIZE(chords); i++) {
+        for (uint8_t order = 0; order < 2; order++) {
+            uint16_t first  = order ? chords[i].key2 : chords[i].key1;
+            uint16_t second = order ? chords[i].key1 : chords[i].key2;
+
+            harness_reports_clear();
+            key_press(first);
+            harness_idle(10);
+            CHECK_EQ(harness_count_reports(REPORT_KEYBOARD), 0);
+
+            // No superset to wait for: the chord goes out in this scan
+            uint32_t completed = harness_scans;
+            key_press(second);
+            CHECK(keyboard_report_is(&harness_last_report(REPORT_KEYBOARD)->keyboard, chords[i].sends));
+            CHECK_EQ(harness_last_report(REPORT_KEYBOARD)->scan, completed);
+
+            key_release(first);
+            CHECK(released_all());
+            key_release(second);
+            harness_idle(100);
+            CHECK(released_all());
+            CHECK(reports_within(chords[i].sends));
+        }
+    }
+}
+
+static void test_pass_through(void) {
+    harness_test("chord key tap");
+    harness_reports_clear();
+    key_tap(KC_SCLN);
+    harness_idle(100);
+    CHECK(key_order(KC_SCLN) != UINT16_MAX);
+    CHECK(released_all());
+
+    harness_test("chord key hold");
+    harness_reports_clear();
+    uint32_t pressed = harness_scans;
+    key_press(KC_SCLN);
+    harness_idle(100);
+    CHECK(scan_down(KC_SCLN) <= pressed + 40 + 1);
+    key_release(KC_SCLN);
+    CHECK(released_all());
+
+    // Keys that break a chord come out after the held-back key, in the same
+    // scan
+    harness_test("chord broken");
+    harness_reports_clear();
+    key_press(KC_SCLN);
+    uint32_t broken = harness_scans;
+    key_press(KC_A);
+    CHECK(key_order(KC_SCLN) < key_order(KC_A));
+    CHECK_EQ(scan_down(KC_A), broken);
+    key_release(KC_SCLN);
+    key_release(KC_A);
+    CHECK(released_all());
+
+    // Chord keys typed quickly without overlapping
+    harness_test("chord keys typed");
+    static const uint16_t typed[] = { KC_SCLN, KC_SLSH, KC_QUOT, KC_A };
+    harness_reports_clear();
+    for (uint8_t i = 0; i < ARRAY_SIZE(typed); i++) {
+        key_tap(typed[i]);
+    }
+    harness_idle(100);
+    for (uint8_t i = 1; i < ARRAY_SIZE(typed); i++) {
+        CHECK(key_order(typed[i - 1]) < key_order(typed[i]));
+    }
+    CHECK(released_all());
+}
+
+// Press first, press second, release first, release second, one scan each
+static void roll(uint16_t first, uint16_t second) {
+    harness_reports_clear();
+    key_press(first);
+    key_press(second);
+    key_release(first);
+    key_release(second);
+    harness_idle(100);
+}
+
+static void test_rolls(void) {
+    // "2023", "345": every pair of neighbouring digits, rolled both ways,
+    // comes out as the two digits, each in the scan it was pressed in
+    harness_test("chord digits rolled");
+    static const uint16_t digits[] = { KC_1, KC_2, KC_3, KC_4, KC_5, KC_6, KC_7, KC_8, KC_9, KC_0 };
+    for (uint8_t i = 1; i < ARRAY_SIZE(digits); i++) {
+        for (uint8_t order = 0; order < 2; order++) {
+            uint16_t first  = order ? digits[i] : digits[i - 1];
+            uint16_t second = order ? digits[i - 1] : digits[i];
+
+            uint32_t pressed = harness_scans;
+            roll(first, second);
+            CHECK(key_order(first) < key_order(second));
+            CHECK(key_order(second) != UINT16_MAX);
+            CHECK_EQ(scan_down(first), pressed);
+            CHECK_EQ(scan_down(second), pressed + 1);
+            CHECK_EQ(harness_count_reports(REPORT_KEYBOARD), 4);
+            CHECK(released_all());
+        }
+    }
+
+    // Keys of two different chords rolled are no chord either
+    harness_test("chord keys rolled");
+    roll(KC_SCLN, KC_QUOT);
+    CHECK(key_order(KC_SCLN) < key_order(KC_QUOT));
+    CHECK(reports_within(KC_NO) == false);
+    CHECK(released_all());
+    roll(KC_TAB, KC_Q);
+    CHECK(key_order(KC_TAB) < key_order(KC_Q));
+    CHECK(released_all());
+}
+
+// Several events in one scan behind a pending chord key, with KC_AG among
+// them: all of them are replayed in order
+static void test_queue(void) {
+    harness_test("chord queue");
+    keypos_t scln  = harness_key_pos(KC_SCLN);
+    keypos_t a     = harness_key_pos(KC_A);
+    keypos_t ag    = harness_key_pos(KC_AG);
+
+    harness_reports_clear();
+    key_press(KC_SCLN);
+    harness_scan_begin();
+    harness_scan_key(ag, true);
+    harness_scan_key(scln, false);
+    harness_scan_key(a, true);
+    harness_scan_end();
+    harness_scan_begin();
+    harness_scan_key(a, false);
+    harness_scan_key(ag, false);
+    harness_scan_end();
+    harness_idle(100);
+
+    uint16_t with_a = key_order(KC_A);
+    CHECK(key_order(KC_SCLN) < with_a);
+    CHECK(with_a != UINT16_MAX && harness_reports[with_a / KEYBOARD_REPORT_KEYS].keyboard.mods == (MOD_BIT(KC_LALT) | MOD_BIT(KC_LGUI)));
+    CHECK(released_all());
+}
+
+int main(void) {
+    harness_boot(OS_MACOS);
+    test_fire();
+    test_pass_through();
+    test_rolls();
+    test_queue();
+
+    harness_test("pipeline");
+    CHECK_EQ(harness_reentries, 0);
+    CHECK_EQ(harness_report_dropped, 0);
+    return harness_done("test_chord");
+}
+
+#else
+
+int main(void) {
+    printf("test_chord: skipped, OS_CHORD_ENABLE is off\n");
+    return 0;
+}
+
+#endif
@@ -0,0 +1,185 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+// HID report coalescing: a modifier and its key pressed in one scan share a
+// report, a press and release in one scan are both sent, system and consumer
+// reports keep their own order and state, and mouse motion is summed only as
+// far as one report can carry.
+
+#include <stdio.h>
+
+#include "keymap.c"
+#include "keymap_introspection.c"
+
+#include "harness.h"
+
+#ifdef REPORT_COALESCE_ENABLE
+
+// The n-th report of type since the last clear, or NULL
+static const harness_report_t *nth_report(uint8_t type, uint16_t n) {
+    for (uint16_t i = 0; i < harness_report_count; i++) {
+        if (harness_reports[i].type == type && n-- == 0) {
+            return &harness_reports[i];
+        }
+    }
+    return NULL;
+}
+
+static bool extra_is(uint16_t n, uint8_t report_id, uint16_t usage) {
+    const harness_report_t *r = nth_report(REPORT_EXTRA, n);
+    return r && r->extra.report_id == report_id && r->extra.usage == usage;
+}
+
+static void test_keyboard(void) {
+    keypos_t ctl = harness_key_pos(KC_LCTL);
+    keypos_t a   = harness_key_pos(KC_A);
+
+    harness_test("coalesce mod and key");
+    harness_reports_clear();
+    uint32_t pressed = harness_scans;
+    harness_scan_begin();
+    harness_scan_key(ctl, true);
+    harness_scan_key(a, true);
+    harness_scan_end();
+    CHECK_EQ(harness_count_reports(REPORT_KEYBOARD), 1);
+    CHECK(keyboard_report_is(&harness_last_report(REPORT_KEYBOARD)->keyboard, C(KC_A)));
+    CHECK_EQ(harness_last_report(REPORT_KEYBOARD)->scan, pressed);
+
+    harness_scan_begin();
+    harness_scan_key(a, false);
+    harness_scan_key(ctl, false);
+    harness_scan_end();
+    CHECK_EQ(harness_count_reports(REPORT_KEYBOARD), 2);
+    CHECK(keyboard_report_is(&harness_last_report(REPORT_KEYBOARD)->keyboard, KC_NO));
+
+    harness_test("coalesce press and release");
+    harness_reports_clear();
+    pressed = harness_scans;
+    harness_scan_begin();
+    harness_scan_key(a, true);
+    harness_scan_key(a, false);
+    harness_scan_end();
+    CHECK_EQ(harness_count_reports(REPORT_KEYBOARD), 2);
+    CHECK(keyboard_report_is(&nth_report(REPORT_KEYBOARD, 0)->keyboard, KC_A));
+    CHECK(keyboard_report_is(&nth_report(REPORT_KEYBOARD, 1)->keyboard, KC_NO));
+    CHECK_EQ(nth_report(REPORT_KEYBOARD, 1)->scan, pressed);
+}
+
+static void test_extra(void) {
+    harness_test("coalesce consumer then system");
+    harness_reports_clear();
+    harness_scan_begin();
+    host_consumer_send(0x00E9);
+    host_consumer_send(0);
+    host_system_send(0x0081);
+    host_system_send(0);
+    harness_scan_end();
+    CHECK_EQ(harness_count_reports(REPORT_EXTRA), 4);
+    CHECK(extra_is(0, REPORT_ID_CONSUMER, 0x00E9));
+    CHECK(extra_is(1, REPORT_ID_CONSUMER, 0));
+    CHECK(extra_is(2, REPORT_ID_SYSTEM, 0x0081));
+    CHECK(extra_is(3, REPORT_ID_SYSTEM, 0));
+
+    // A consumer key held across a system tap: its release is still compared
+    // with the consumer usage the host holds, not the last system report
+    harness_test("coalesce consumer held over system");
+    harness_reports_clear();
+    harness_scan_begin();
+    host_consumer_send(0x00E9);
+    harness_scan_end();
+    harness_scan_begin();
+    host_system_send(0x0082);
+    host_system_send(0);
+    harness_scan_end();
+    harness_scan_begin();
+    host_consumer_send(0);
+    host_consumer_send(0x00EA);
+    harness_scan_end();
+    harness_scan_begin();
+    host_consumer_send(0);
+    harness_scan_end();
+    CHECK_EQ(harness_count_reports(REPORT_EXTRA), 6);
+    CHECK(extra_is(0, REPORT_ID_CONSUMER, 0x00E9));
+    CHECK(extra_is(1, REPORT_ID_SYSTEM, 0x0082));
+    CHECK(extra_is(2, REPORT_ID_SYSTEM, 0));
+    CHECK(extra_is(3, REPORT_ID_CONSUMER, 0));
+    CHECK(extra_is(4, REPORT_ID_CONSUMER, 0x00EA));
+    CHECK(extra_is(5, REPORT_ID_CONSUMER, 0));
+}
+
+static void send_motion(int8_t x, int8_t y, int8_t v, int8_t h) {
+    report_mouse_t report = { .x = x, .y = y, .v = v, .h = h };
+    host_mouse_send(&report);
+}
+
+static void test_mouse(void) {
+    harness_test("coalesce mouse limits");
+
+    // Sums up to exactly INT8_MAX and INT8_MIN fit one report
+    harness_reports_clear();
+    harness_scan_begin();
+    send_motion(60, -60, 1, -1);
+    send_motion(60, -60, 1, -1);
+    send_motion(7, -8, 125, -126);
+    harness_scan_end();
+    CHECK_EQ(harness_count_reports(REPORT_MOUSE), 1);
+    const report_mouse_t *sum = &harness_last_report(REPORT_MOUSE)->mouse;
+    CHECK_EQ(sum->x, INT8_MAX);
+    CHECK_EQ(sum->y, INT8_MIN);
+    CHECK_EQ(sum->v, INT8_MAX);
+    CHECK_EQ(sum->h, INT8_MIN);
+
+    // One step past the limit on any axis starts a new report, and no motion
+    // is lost
+    static const int8_t step[4][4] = {
+        { 1, 0, 0, 0 },
+        { 0, -1, 0, 0 },
+        { 0, 0, 1, 0 },
+        { 0, 0, 0, -1 },
+    };
+    for (uint8_t axis = 0; axis < 4; axis++) {
+        harness_reports_clear();
+        harness_scan_begin();
+        send_motion(INT8_MAX, INT8_MIN, INT8_MAX, INT8_MIN);
+        send_motion(step[axis][0], step[axis][1], step[axis][2], step[axis][3]);
+        harness_scan_end();
+        CHECK_EQ(harness_count_reports(REPORT_MOUSE), 2);
+        const report_mouse_t *first = &nth_report(REPORT_MOUSE, 0)->mouse;
+        const report_mouse_t *next  = &nth_report(REPORT_MOUSE, 1)->mouse;
+        CHECK_EQ(first->x + next->x, INT8_MAX + step[axis][0]);
+        CHECK_EQ(first->y + next->y, INT8_MIN + step[axis][1]);
+        CHECK_EQ(first->v + next->v, INT8_MAX + step[axis][2]);
+        CHECK_EQ(first->h + next->h, INT8_MIN + step[axis][3]);
+    }
+
+    // A button change is never merged into motion
+    harness_test("coalesce mouse buttons");
+    harness_reports_clear();
+    harness_scan_begin();
+    send_motion(5, 5, 0, 0);
+    report_mouse_t click = { .buttons = 1 };
+    host_mouse_send(&click);
+    click.buttons = 0;
+    host_mouse_send(&click);
+    harness_scan_end();
+    CHECK_EQ(harness_count_reports(REPORT_MOUSE), 3);
+    CHECK_EQ(nth_report(REPORT_MOUSE, 0)->mouse.x, 5);
+    CHECK_EQ(nth_report(REPORT_MOUSE, 1)->mouse.buttons, 1);
+    CHECK_EQ(nth_report(REPORT_MOUSE, 2)->mouse.buttons, 0);
+}
+
+int main(void) {
+    harness_boot(OS_MACOS);
+    test_keyboard();
+    test_extra();
+    test_mouse();
+    return harness_done("test_coalesce");
+}
+
+#else
+
+int main(void) {
+    printf("test_coalesce: skipped, REPORT_COALESCE_ENABLE is off\n");
+    return 0;
+}
+
+#endif
@@ -0,0 +1,205 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+// Eager debounce, driven directly with scripted raw matrix states one
+// millisecond apart: every clean press or release gives exactly one edge,
+// presses are reported on their first contact, and bounce never adds edges.
+
+#include <stdio.h>
+
+#include "keymap.c"
+#include "keymap_introspection.c"
+
+#include "harness.h"
+
+#ifdef EAGER_DEBOUNCE_ENABLE
+
+static matrix_row_t raw[MATRIX_ROWS];
+static matrix_row_t last_raw[MATRIX_ROWS];
+static matrix_row_t cooked[MATRIX_ROWS];
+
+typedef struct {
+    uint16_t presses;
+    uint16_t releases;
+    uint32_t last_press;    // ms of the last press edge
+    uint32_t last_release;  // ms of the last release edge
+} edges_t;
+
+static edges_t edges[MATRIX_ROWS][MATRIX_COLS];
+
+static void reset(uint32_t time) {
+    harness_time = time;
+    memset(raw, 0, sizeof(raw));
+    memset(last_raw, 0, sizeof(last_raw));
+    memset(cooked, 0, sizeof(cooked));
+    memset(edges, 0, sizeof(edges));
+    debounce_init(MATRIX_ROWS);
+}
+
+// One scan, then a millisecond passes
+static void scan(void) {
+    matrix_row_t before[MATRIX_ROWS];
+    memcpy(before, cooked, sizeof(before));
+
+    bool changed = memcmp(raw, last_raw, sizeof(raw)) != 0;
+    memcpy(last_raw, raw, sizeof(raw));
+    bool cooked_changed = debounce(raw, cooked, MATRIX_ROWS, changed);
+    CHECK_EQ(cooked_changed, memcmp(before, cooked, sizeof(before)) != 0);
+
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+            matrix_row_t bit = MATRIX_ROW_SHIFTER << col;
+            if (cooked[row] & ~before[row] & bit) {
+                edges[row][col].presses++;
+                edges[row][col].last_press = harness_time;
+            }
+            if (before[row] & ~cooked[row] & bit) {
+                edges[row][col].releases++;
+                edges[row][col].last_release = harness_time;
+            }
+        }
+    }
+    harness_time++;
+}
+
+static void idle(uint16_t ms) {
+    while (ms--) {
+        scan();
+    }
+}
+
+// Plays script on one key, a character per ms: '1' closed, '0' open
+static void play(uint8_t row, uint8_t col, const char *script) {
+    for (; *script; script++) {
+        if (*script == '1') {
+            raw[row] |= MATRIX_ROW_SHIFTER << col;
+        } else {
+            raw[row] &= ~(MATRIX_ROW_SHIFTER << col);
+        }
+        scan();
+    }
+}
+
+static void test_clean(void) {
+    harness_test("debounce clean");
+    reset(1000);
+    play(1, 2, "1");
+    CHECK_EQ(edges[1][2].presses, 1);
+    CHECK_EQ(edges[1][2].last_press, 1000);
+    play(1, 2, "1111111111111111111");
+    play(1, 2, "0");
+    idle(20);
+    CHECK_EQ(edges[1][2].presses, 1);
+    CHECK_EQ(edges[1][2].releases, 1);
+    CHECK_EQ(edges[1][2].last_release, 1020 + DEBOUNCE);
+}
+
+static void test_bounce(void) {
+    harness_test("debounce bounce");
+    reset(1000);
+
+    // Bounce on contact and on release, shorter than DEBOUNCE each
+    play(3, 4, "1010110111111111111111111");
+    CHECK_EQ(edges[3][4].presses, 1);
+    CHECK_EQ(edges[3][4].last_press, 1000);
+    CHECK_EQ(edges[3][4].releases, 0);
+
+    uint32_t opened = harness_time;
+    play(3, 4, "0101001");
+    uint32_t settled = harness_time;
+    play(3, 4, "0");
+    idle(20);
+    CHECK_EQ(edges[3][4].presses, 1);
+    CHECK_EQ(edges[3][4].releases, 1);
+    CHECK(edges[3][4].last_release > opened);
+    CHECK_EQ(edges[3][4].last_release, settled + DEBOUNCE);
+
+    // A one-scan dropout while held is no release
+    play(3, 4, "1111111111");
+    play(3, 4, "0");
+    play(3, 4, "1111111111");
+    CHECK_EQ(edges[3][4].presses, 2);
+    CHECK_EQ(edges[3][4].releases, 1);
+}
+
+static void test_fast_taps(void) {
+    harness_test("debounce fast taps");
+    reset(1000);
+
+    // Ten taps with bounce at both ends, 25 ms down and 25 ms up
+    for (uint8_t i = 0; i < 10; i++) {
+        play(0, 1, "1011111111111111111111111");
+        play(0, 1, "0100000000000000000000000");
+    }
+    idle(20);
+    CHECK_EQ(edges[0][1].presses, 10);
+    CHECK_EQ(edges[0][1].releases, 10);
+}
+
+static void test_rows(void) {
+    harness_test("debounce rows");
+    reset(1000);
+
+    // Keys on several rows bouncing at the same time stay independent
+    for (uint8_t i = 0; i < 6; i++) {
+        raw[0] ^= 1 << 0;
+        raw[4] ^= 1 << 5;
+        raw[9] ^= (i & 1) ? 0 : 1 << 3;
+        scan();
+    }
+    raw[0] |= 1 << 0;
+    raw[4] |= 1 << 5;
+    raw[9] |= 1 << 3;
+    idle(20);
+    CHECK_EQ(edges[0][0].presses, 1);
+    CHECK_EQ(edges[4][5].presses, 1);
+    CHECK_EQ(edges[9][3].presses, 1);
+
+    memset(raw, 0, sizeof(raw));
+    idle(20);
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+            CHECK_EQ(edges[row][col].presses, edges[row][col].releases);
+        }
+    }
+}
+
+static void test_timer(void) {
+    harness_test("debounce timer wrap");
+    reset(0xFFFE);
+    play(2, 0, "11111111110");
+    idle(20);
+    CHECK_EQ(edges[2][0].presses, 1);
+    CHECK_EQ(edges[2][0].releases, 1);
+    CHECK_EQ(edges[2][0].last_release, 0xFFFE + 10 + DEBOUNCE);
+
+    // A scan gap longer than a countdown byte holds: the release still
+    // needs DEBOUNCE ms of open readings after it
+    harness_test("debounce scan gap");
+    play(2, 0, "1");
+    raw[2] = 0;
+    scan();
+    harness_time += 1000;
+    idle(DEBOUNCE - 1);
+    CHECK_EQ(edges[2][0].releases, 1);
+    idle(2);
+    CHECK_EQ(edges[2][0].presses, 2);
+    CHECK_EQ(edges[2][0].releases, 2);
+}
+
+int main(void) {
+    test_clean();
+    test_bounce();
+    test_fast_taps();
+    test_rows();
+    test_timer();
+    return harness_done("test_debounce");
+}
+
+#else
+
+int main(void) {
+    printf("test_debounce: skipped, EAGER_DEBOUNCE_ENABLE is off\n");
+    return 0;
+}
+
+#endif
@@ -0,0 +1,348 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+// Key traces through the whole keymap: base layer typing, the OS-aware keys
+// on every os_variant_t, and the tri-layer thumb keys.
+
+#include <stdio.h>
+
+#include "keymap.c"
+#include "keymap_introspection.c"
+
+#include "harness.h"
+
+static const os_variant_t all_os[] = { OS_UNSURE, OS_LINUX, OS_WINDOWS, OS_MACOS, OS_IOS };
+
+// Detection never reports OS_UNSURE over a known OS, so that column is what
+// a fresh board sends before detection completes
+static void use_os(os_variant_t os) {
+    harness_set_os(os);
+    if (os == OS_UNSURE) {
+        current_os = OS_UNSURE;
+    }
+}
+
+// Layer key that reaches keycode, for keys that only live on upper layers
+static uint16_t layer_key_for(uint16_t keycode) {
+    keypos_t pos;
+    for (uint8_t layer = 0; layer < ARRAY_SIZE(keymaps); layer++) {
+        for (pos.row = 0; pos.row < MATRIX_ROWS; pos.row++) {
+            for (pos.col = 0; pos.col < MATRIX_COLS; pos.col++) {
+                if (keycode_at_keymap_location_raw(layer, pos.row, pos.col) != keycode) {
+                    continue;
+                }
+                switch (layer) {
+                    case _BASIC:       return KC_NO;
+                    case _LEFT_UNDER:  return LEFT_UNDER;
+                    case _RIGHT_UNDER: return RIGHT_UNDER;
+                    default:           return MO(_LEFT_UP);
+                }
+            }
+        }
+    }
+    return KC_NO;
+}
+
+// True if a keyboard report since the last clear held exactly keycode
+static bool reports_hold(uint16_t keycode) {
+    for (uint16_t i = 0; i < harness_report_count; i++) {
+        if (harness_reports[i].type == REPORT_KEYBOARD && keyboard_report_is(&harness_reports[i].keyboard, keycode)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Holds the layer key, presses keycode and checks the report while it is
+// held and after it is released. Returns true if a report in the press scan
+// held expected.
+static bool press_on_layer(uint16_t keycode, uint16_t expected) {
+    uint16_t layer_key = layer_key_for(keycode);
+    if (layer_key != KC_NO) {
+        key_press(layer_key);
+    }
+
+    harness_reports_clear();
+    key_press(keycode);
+    bool sent = reports_hold(expected);
+    key_release(keycode);
+    CHECK(keyboard_report_is(&harness_last_report(REPORT_KEYBOARD)->keyboard, KC_NO));
+
+    if (layer_key != KC_NO) {
+        key_release(layer_key);
+    }
+    CHECK_EQ(layer_state, 0);
+    return sent;
+}
+
+static void test_base_typing(void) {
+    harness_test("base typing");
+    harness_reports_clear();
+
+    key_press(KC_LSFT);
+    key_tap(KC_H);
+    key_release(KC_LSFT);
+    key_tap(KC_I);
+
+    static const struct {
+        uint8_t mods;
+        uint8_t key;
+    } expected[] = {
+        { MOD_BIT(KC_LSFT), KC_NO },
+        { MOD_BIT(KC_LSFT), KC_H },
+        { MOD_BIT(KC_LSFT), KC_NO },
+        { 0, KC_NO },
+        { 0, KC_I },
+        { 0, KC_NO },
+    };
+    if (CHECK_EQ(harness_report_count, ARRAY_SIZE(expected))) {
+        for (uint8_t i = 0; i < ARRAY_SIZE(expected); i++) {
+            CHECK_EQ(harness_reports[i].type, REPORT_KEYBOARD);
+            CHECK_EQ(harness_reports[i].keyboard.mods, expected[i].mods);
+            CHECK_EQ(harness_reports[i].keyboard.keys[0], expected[i].key);
+        }
+    }
+}
+
+// What each OS-aware key must send, per os_variant_t
+static const struct {
+    uint16_t keycode;
+    uint16_t sends[OS_VARIANT_COUNT];
+} os_expected[] = {
+    { SC_FULL,      { LSG(KC_3),       KC_PSCR,          G(S(KC_S)),   LSG(KC_3),       LSG(KC_3)       } },
+    { SC_AREA,      { LSG(KC_4),       S(KC_PSCR),       G(S(KC_S)),   LSG(KC_4),       LSG(KC_4)       } },
+    { SC_MENU,      { LSG(KC_5),       KC_PSCR,          G(S(KC_S)),   LSG(KC_5),       LSG(KC_5)       } },
+    { SC_CLIP_FULL, { LSG(C(KC_3)),    C(KC_PSCR),       G(S(KC_S)),   LSG(C(KC_3)),    LSG(C(KC_3))    } },
+    { SC_CLIP_AREA, { LSG(C(KC_4)),    C(S(KC_PSCR)),    G(S(KC_S)),   LSG(C(KC_4)),    LSG(C(KC_4))    } },
+    { LANG_SW,      { C(KC_SPC),       S(KC_SPC),        KC_RALT,      C(KC_SPC),       KC_CAPS         } },
+    { GO_BACK,      { G(KC_LBRC),      A(KC_LEFT),       A(KC_LEFT),   G(KC_LBRC),      G(KC_LBRC)      } },
+    { GO_FORWARD,   { G(KC_RBRC),      A(KC_RGHT),       A(KC_RGHT),   G(KC_RBRC),      G(KC_RBRC)      } },
+    { GO_UPPER,     { G(KC_UP),        A(KC_UP),         A(KC_UP),     G(KC_UP),        G(KC_UP)        } },
+    { GO_LOWER,     { G(KC_DOWN),      KC_ENT,           KC_ENT,       G(KC_DOWN),      G(KC_DOWN)      } },
+    { KC_EMOJI,     { G(C(KC_SPC)),    C(KC_DOT),        G(KC_DOT),    G(C(KC_SPC)),    G(C(KC_SPC))    } },
+    { TAP_P,        { G(KC_GRV),       A(KC_GRV),        A(KC_ESC),    G(KC_GRV),       G(KC_GRV)       } },
+};
+
+static void test_os_keys(void) {
+    for (uint8_t o = 0; o < ARRAY_SIZE(all_os); o++) {
+        os_variant_t os = all_os[o];
+        use_os(os);
+
+        for (uint8_t i = 0; i < ARRAY_SIZE(os_expected); i++) {
+            uint16_t keycode = os_expected[i].keycode;
+            bool     sent    = press_on_layer(keycode, os_expected[i].sends[os]);
+
+            #ifndef OS_ACTIONS_ENABLE
+            // Without the action table the OS actions send nothing
+            if ((uint16_t)(keycode - OS_ACTION_FIRST) < OS_ACTION_COUNT) {
+                harness_test("os actions disabled");
+                CHECK(!sent);
+                continue;
+            }
+            #endif
+            #ifndef OS_MACROS_ENABLE
+            // Nor do the OS macros without the macro scheduler
+            if ((uint16_t)(keycode - OS_MACRO_FIRST) < OS_MACRO_COUNT) {
+                harness_test("os macros disabled");
+                CHECK(!sent);
+                continue;
+            }
+            #endif
+            harness_test("os keys");
+            if (!sent) {
+                fprintf(stderr, "  os %u, keycode 0x%04x\n", os, keycode);
+            }
+            CHECK(sent);
+        }
+    }
+}
+
+#ifdef OS_MACROS_ENABLE
+// Single-step macros stay down while held, so the host repeats them
+static void test_macro_hold(void) {
+    harness_test("macro hold");
+    for (uint8_t o = 0; o < ARRAY_SIZE(all_os); o++) {
+        os_variant_t os = all_os[o];
+        use_os(os);
+
+        for (uint8_t i = 0; i < ARRAY_SIZE(os_expected); i++) {
+            uint16_t keycode = os_expected[i].keycode;
+            if ((uint16_t)(keycode - OS_MACRO_FIRST) >= OS_MACRO_COUNT) {
+                continue;
+            }
+            uint16_t layer_key = layer_key_for(keycode);
+
+            key_press(layer_key);
+            key_press(keycode);
+            harness_idle(1000);
+            CHECK(keyboard_report_is(&harness_last_report(REPORT_KEYBOARD)->keyboard, os_expected[i].sends[os]));
+            key_release(keycode);
+            CHECK(keyboard_report_is(&harness_last_report(REPORT_KEYBOARD)->keyboard, KC_NO));
+            key_release(layer_key);
+        }
+    }
+}
+#endif
+
+static void test_wheel_direction(void) {
+    harness_test("wheel direction");
+    for (uint8_t o = 0; o < ARRAY_SIZE(all_os); o++) {
+        os_variant_t os = all_os[o];
+        use_os(os);
+
+        #ifdef OS_WHEEL_ENABLE
+        int8_t up = (os == OS_MACOS || os == OS_IOS) ? 1 : -1;
+        #else
+        int8_t up = 1;
+        #endif
+
+        key_press(MO(_LEFT_UP));
+        harness_reports_clear();
+        key_press(MW_UP);
+        harness_idle(20);
+        key_release(MW_UP);
+        harness_idle(500);
+        key_release(MO(_LEFT_UP));
+
+        CHECK(harness_count_reports(REPORT_MOUSE) > 0);
+        for (uint16_t i = 0; i < harness_report_count; i++) {
+            if (harness_reports[i].type == REPORT_MOUSE && harness_reports[i].mouse.v) {
+                CHECK_EQ(harness_reports[i].mouse.v, up);
+                CHECK_EQ(harness_reports[i].mouse.h, 0);
+            }
+        }
+    }
+}
+
+static void test_lang_keys(void) {
+    harness_test("language keys");
+    for (uint8_t o = 0; o < ARRAY_SIZE(all_os); o++) {
+        os_variant_t os = all_os[o];
+        use_os(os);
+
+        // Unknown state: the first LANG_KO sends LANG_SW, the second nothing
+        uint16_t lang_sw = os_expected[5].sends[os];
+        #ifdef OS_ACTIONS_ENABLE
+        CHECK(press_on_layer(LANG_KO, lang_sw));
+        CHECK(!press_on_layer(LANG_KO, lang_sw));
+        CHECK(press_on_layer(LANG_EN, lang_sw));
+        CHECK(!press_on_layer(LANG_EN, lang_sw));
+        #else
+        CHECK(!press_on_layer(LANG_KO, lang_sw));
+        #endif
+    }
+
+    #ifdef OS_ACTIONS_ENABLE
+    // The host was already in Korean: the blind LANG_SW switched it to
+    // English. Shift + LANG_EN records that without sending anything, and
+    // the next LANG_KO switches back.
+    harness_test("language wrong guess");
+    for (uint8_t o = 0; o < ARRAY_SIZE(all_os); o++) {
+        os_variant_t os = all_os[o];
+        use_os(os);
+        lang_state[os] = LANG_UNKNOWN;
+
+        uint16_t lang_sw = os_expected[5].sends[os];
+        CHECK(press_on_layer(LANG_KO, lang_sw));
+        key_press(KC_LSFT);
+        harness_reports_clear();
+        press_on_layer(LANG_EN, KC_NO);
+        CHECK_EQ(harness_count_reports(REPORT_KEYBOARD), 0);
+        key_release(KC_LSFT);
+        CHECK(press_on_layer(LANG_KO, lang_sw));
+        CHECK(!press_on_layer(LANG_KO, lang_sw));
+    }
+    #endif
+}
+
+static void test_tri_layer(void) {
+    harness_test("tri-layer");
+    keypos_t one = harness_key_pos(KC_1);
+
+    // One thumb key: its own layer
+    key_press(LEFT_UNDER);
+    CHECK_EQ(layer_state, 1 << _LEFT_UNDER);
+    harness_reports_clear();
+    key_tap(KC_1);
+    CHECK(reports_hold(KC_EXLM));
+    key_release(LEFT_UNDER);
+    CHECK_EQ(layer_state, 0);
+
+    key_press(RIGHT_UNDER);
+    CHECK_EQ(layer_state, 1 << _RIGHT_UNDER);
+    harness_reports_clear();
+    key_tap(KC_1);
+    CHECK(reports_hold(KC_F1));
+    key_release(RIGHT_UNDER);
+    CHECK_EQ(layer_state, 0);
+
+    // Both, in either order: _BOTH_UNDER on top, transparent keys fall
+    // through to _RIGHT_UNDER
+    for (uint8_t order = 0; order < 2; order++) {
+        uint16_t first  = order ? RIGHT_UNDER : LEFT_UNDER;
+        uint16_t second = order ? LEFT_UNDER : RIGHT_UNDER;
+
+        key_press(first);
+        key_press(second);
+        CHECK_EQ(layer_state, (1 << _LEFT_UNDER) | (1 << _RIGHT_UNDER) | (1 << _BOTH_UNDER));
+
+        harness_reports_clear();
+        key_tap(KC_TAB);
+        CHECK(reports_hold(KC_LPRN));
+        harness_reports_clear();
+        key_tap(KC_1);
+        CHECK(reports_hold(KC_F1));
+
+        // Releasing the first thumb key leaves the other one's layer
+        key_release(first);
+        CHECK_EQ(layer_state, 1 << (order ? _LEFT_UNDER : _RIGHT_UNDER));
+        key_release(second);
+        CHECK_EQ(layer_state, 0);
+    }
+
+    // A key held across a layer change is released as what it was pressed as
+    key_press(LEFT_UNDER);
+    harness_scan_begin();
+    harness_scan_key(one, true);
+    harness_scan_end();
+    CHECK(keyboard_report_is(&harness_last_report(REPORT_KEYBOARD)->keyboard, KC_EXLM));
+    key_release(LEFT_UNDER);
+    harness_scan_begin();
+    harness_scan_key(one, false);
+    harness_scan_end();
+    CHECK(keyboard_report_is(&harness_last_report(REPORT_KEYBOARD)->keyboard, KC_NO));
+
+    // Pressed as _RIGHT_UNDER's F1 through transparent _BOTH_UNDER, released
+    // after _BOTH_UNDER and _RIGHT_UNDER are gone: F1 must not stay down
+    key_press(LEFT_UNDER);
+    key_press(RIGHT_UNDER);
+    harness_scan_begin();
+    harness_scan_key(one, true);
+    harness_scan_end();
+    CHECK(keyboard_report_is(&harness_last_report(REPORT_KEYBOARD)->keyboard, KC_F1));
+    key_release(RIGHT_UNDER);
+    harness_scan_begin();
+    harness_scan_key(one, false);
+    harness_scan_end();
+    CHECK(keyboard_report_is(&harness_last_report(REPORT_KEYBOARD)->keyboard, KC_NO));
+    key_release(LEFT_UNDER);
+    CHECK_EQ(layer_state, 0);
+}
+
+int main(void) {
+    harness_boot(OS_MACOS);
+
+    test_base_typing();
+    test_os_keys();
+    #ifdef OS_MACROS_ENABLE
+    test_macro_hold();
+    #endif
+    test_wheel_direction();
+    test_lang_keys();
+    test_tri_layer();
+
+    harness_test("pipeline");
+    CHECK_EQ(harness_reentries, 0);
+    CHECK_EQ(harness_wait_ms_calls, 0);
+    CHECK_EQ(harness_report_dropped, 0);
+    return harness_done("test_keymap");
+}
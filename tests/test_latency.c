@@ -0,0 +1,176 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+// The latency histogram gets one sample per key event, including the keys
+// that keymap.c handles itself and QMK never post-processes, and with report
+// coalescing the sample ends when the report is sent. Samples land in the
+// bucket for their delay, and LAT_DUMP prints the histogram as recorded.
+
+#include <stdio.h>
+
+#include "keymap.c"
+#include "keymap_introspection.c"
+
+#include "harness.h"
+
+#if defined(LATENCY_HISTOGRAM_ENABLE) && defined(CONSOLE_ENABLE)
+
+typedef struct {
+    unsigned ticks_per_ms;
+    unsigned bucket_width;
+    unsigned max;
+    unsigned buckets[LATENCY_BUCKET_COUNT];
+} lat_dump_t;
+
+// Parses the last LAT line on the console
+static bool parse_dump(lat_dump_t *out) {
+    const char *line = NULL;
+    for (const char *c = harness_console; (c = strstr(c, "LAT ")); c++) {
+        line = c;
+    }
+    if (!line) {
+        return false;
+    }
+
+    int used;
+    if (sscanf(line, "LAT %u %u %u%n", &out->ticks_per_ms, &out->bucket_width, &out->max, &used) != 3) {
+        return false;
+    }
+    for (uint8_t i = 0; i < LATENCY_BUCKET_COUNT; i++) {
+        int more;
+        line += used;
+        if (sscanf(line, " %u%n", &out->buckets[i], &more) != 1) {
+            return false;
+        }
+        used = more;
+    }
+    return true;
+}
+
+// Samples in the last LAT line on the console, or -1 without one
+static long dumped_samples(void) {
+    lat_dump_t parsed;
+    if (!parse_dump(&parsed)) {
+        return -1;
+    }
+    long total = 0;
+    for (uint8_t i = 0; i < LATENCY_BUCKET_COUNT; i++) {
+        total += parsed.buckets[i];
+    }
+    return total;
+}
+
+static void dump(void) {
+    harness_console_clear();
+    key_press(MO(_LEFT_UP));
+    key_tap(LAT_DUMP);
+    key_release(MO(_LEFT_UP));
+}
+
+static void test_every_event(void) {
+    harness_test("latency samples");
+
+    // Keys QMK processes, and keys process_record_user handles and returns
+    // false for: thumb layer keys, OS actions, OS macros, language keys,
+    // the cursor engine
+    static const uint16_t taps[] = { KC_A, KC_J, KC_SPC };
+    static const uint16_t layer_taps[][2] = {
+        { MO(_LEFT_UP), SC_FULL },
+        { MO(_LEFT_UP), GO_BACK },
+        { MO(_LEFT_UP), MS_LEFT },
+        { MO(_LEFT_UP), MW_UP },
+        { LEFT_UNDER, LANG_KO },
+        { LEFT_UNDER, KC_EMOJI },
+        { RIGHT_UNDER, TAP_P },
+    };
+
+    latency_reset();
+    long events = 0;
+    for (uint8_t i = 0; i < ARRAY_SIZE(taps); i++) {
+        key_tap(taps[i]);
+        events += 2;
+    }
+    for (uint8_t i = 0; i < ARRAY_SIZE(layer_taps); i++) {
+        key_press(layer_taps[i][0]);
+        key_tap(layer_taps[i][1]);
+        key_release(layer_taps[i][0]);
+        events += 4;
+    }
+    harness_idle(100);
+
+    // The LAT_DUMP press itself is recorded after the dump is printed
+    dump();
+    CHECK_EQ(dumped_samples(), events + 1);
+}
+
+// A key event that reaches the keymap 50 ms after the scan that saw it, as
+// QMK replays events held back by tap-hold or combos with their own time,
+// lands in the bucket for 50 ms and is the maximum; keys processed in their
+// own scan land in the first bucket. The dump prints exactly that.
+static void test_buckets(void) {
+    harness_test("latency buckets");
+    keypos_t b = harness_key_pos(KC_B);
+
+    latency_reset();
+    key_tap(KC_A);
+    harness_scan_begin();
+    action_exec((keyevent_t){ .key = b, .pressed = true, .time = timer_read() - 50, .type = 1 });
+    harness_scan_end();
+    key_release(KC_B);
+
+    uint16_t late = (50 * LATENCY_TICKS_PER_MS) >> LATENCY_BUCKET_SHIFT;
+    CHECK_EQ(latency_max, 50 * LATENCY_TICKS_PER_MS);
+    CHECK_EQ(latency_buckets[0], 3);
+    CHECK_EQ(latency_buckets[late], 1);
+
+    // The layer key press before LAT_DUMP is in the first bucket as well
+    harness_test("latency dump");
+    dump();
+    lat_dump_t parsed;
+    CHECK(parse_dump(&parsed));
+    CHECK_EQ(parsed.ticks_per_ms, LATENCY_TICKS_PER_MS);
+    CHECK_EQ(parsed.bucket_width, 1 << LATENCY_BUCKET_SHIFT);
+    CHECK_EQ(parsed.max, 50 * LATENCY_TICKS_PER_MS);
+    for (uint8_t i = 0; i < LATENCY_BUCKET_COUNT; i++) {
+        CHECK_EQ(parsed.buckets[i], i == 0 ? 4 : i == late ? 1 : 0);
+    }
+}
+
+#ifdef REPORT_COALESCE_ENABLE
+// A coalesced report only goes out from housekeeping: the sample ends there,
+// not when the key has been processed
+static void test_coalesced(void) {
+    harness_test("latency coalesced report");
+    keypos_t a = harness_key_pos(KC_A);
+
+    latency_reset();
+    harness_reports_clear();
+    harness_scan_begin();
+    harness_scan_key(a, true);
+    CHECK_EQ(harness_count_reports(REPORT_KEYBOARD), 0);
+    harness_time += 40;
+    harness_scan_end();
+    CHECK_EQ(harness_count_reports(REPORT_KEYBOARD), 1);
+    CHECK_EQ(latency_max, 40 * LATENCY_TICKS_PER_MS);
+    CHECK_EQ(latency_buckets[(40 * LATENCY_TICKS_PER_MS) >> LATENCY_BUCKET_SHIFT], 1);
+    key_release(KC_A);
+}
+#endif
+
+int main(void) {
+    harness_boot(OS_MACOS);
+    test_every_event();
+    test_buckets();
+    #ifdef REPORT_COALESCE_ENABLE
+    test_coalesced();
+    #endif
+    return harness_done("test_latency");
+}
+
+#else
+
+int main(void) {
+    printf("test_latency: skipped, LATENCY_HISTOGRAM_ENABLE or CONSOLE_ENABLE is off\n");
+    return 0;
+}
+
+#endif
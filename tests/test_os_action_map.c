@@ -0,0 +1,77 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+// OS action overrides over raw HID, the way tools/os_action_map.py sends
+// them: accepted keycodes take effect on the key, anything process_os_action
+// cannot send is rejected, and KC_NO restores the table default.
+
+#include <stdio.h>
+
+#include "keymap.c"
+#include "keymap_introspection.c"
+
+#include "harness.h"
+
+#if defined(OS_ACTION_REMAP_ENABLE) && defined(RAW_ENABLE)
+
+static uint8_t set_override(uint8_t action, uint8_t os, uint16_t keycode) {
+    uint8_t data[RAW_EPSIZE] = { RAW_HID_OS_ACTION_SET, action, os, keycode & 0xFF, keycode >> 8 };
+    raw_hid_receive(data, sizeof(data));
+    return harness_raw_hid[3];
+}
+
+// Keyboard report while SC_AREA is held
+static bool sc_area_sends(uint16_t keycode) {
+    key_press(MO(_LEFT_UP));
+    key_press(SC_AREA);
+    bool sent = keyboard_report_is(&harness_last_report(REPORT_KEYBOARD)->keyboard, keycode);
+    key_release(SC_AREA);
+    key_release(MO(_LEFT_UP));
+    return sent;
+}
+
+static void test_accepted(void) {
+    harness_test("override accepted");
+    CHECK_EQ(set_override(OS_ACTION_SC_AREA, OS_MACOS, C(KC_A)), OS_ACTION_OK);
+    CHECK(sc_area_sends(C(KC_A)));
+    CHECK_EQ(set_override(OS_ACTION_SC_AREA, OS_MACOS, KC_F12), OS_ACTION_OK);
+    CHECK(sc_area_sends(KC_F12));
+    CHECK_EQ(set_override(OS_ACTION_MW_UP, OS_MACOS, MS_WHLD), OS_ACTION_OK);
+    CHECK_EQ(set_override(OS_ACTION_MW_UP, OS_MACOS, KC_NO), OS_ACTION_OK);
+
+    // KC_NO clears the override
+    CHECK_EQ(set_override(OS_ACTION_SC_AREA, OS_MACOS, KC_NO), OS_ACTION_OK);
+    CHECK(sc_area_sends(LSG(KC_4)));
+}
+
+static void test_rejected(void) {
+    harness_test("override rejected");
+    static const uint16_t rejected[] = { MO(_LEFT_UP), OSM(MOD_LSFT), QK_BOOT, RM_TOGG, SAFE_RANGE, QK_LAYER_TAP | KC_A };
+
+    for (uint8_t i = 0; i < ARRAY_SIZE(rejected); i++) {
+        CHECK_EQ(set_override(OS_ACTION_SC_AREA, OS_MACOS, rejected[i]), OS_ACTION_INVALID);
+    }
+    CHECK(sc_area_sends(LSG(KC_4)));
+
+    // Nothing was stored, so every slot is still free
+    for (uint8_t i = 0; i < OS_ACTION_OVERRIDE_COUNT; i++) {
+        CHECK_EQ(user_data.os_action_overrides[i].keycode, KC_NO);
+    }
+    CHECK_EQ(set_override(OS_ACTION_COUNT, OS_MACOS, KC_A), OS_ACTION_INVALID);
+    CHECK_EQ(set_override(OS_ACTION_SC_AREA, OS_VARIANT_COUNT, KC_A), OS_ACTION_INVALID);
+}
+
+int main(void) {
+    harness_boot(OS_MACOS);
+    test_accepted();
+    test_rejected();
+    return harness_done("test_os_action_map");
+}
+
+#else
+
+int main(void) {
+    printf("test_os_action_map: skipped, OS_ACTION_REMAP_ENABLE or RAW_ENABLE is off\n");
+    return 0;
+}
+
+#endif
@@ -0,0 +1,104 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+// RGB idle scaling: frame rate and brightness while idle, black frames at
+// a low rate once QMK's RGB_MATRIX_TIMEOUT has passed, the enable flag left
+// to the user, and the first key after a timeout reported in the scan it was
+// pressed in, before the RGB matrix lights up again.
+
+#include <stdio.h>
+
+#include "keymap.c"
+#include "keymap_introspection.c"
+
+#include "harness.h"
+
+#if defined(RGB_IDLE_ENABLE) && defined(RGB_MATRIX_ENABLE)
+
+// Frames rendered over the next ms of idle scans, and how many were black
+static uint16_t dark;
+
+static uint16_t frames_over(uint32_t ms) {
+    uint16_t frames = harness_rgb_frames;
+    uint16_t black  = harness_rgb_dark_frames;
+    harness_idle(ms);
+    dark = harness_rgb_dark_frames - black;
+    return harness_rgb_frames - frames;
+}
+
+static void test_levels(void) {
+    harness_test("rgb idle levels");
+    key_tap(KC_A);
+    uint8_t val = rgb_matrix_get_val();
+
+    CHECK_EQ(frames_over(1600), 1600 / 16);
+    CHECK_EQ(dark, 0);
+    CHECK_EQ(rgb_idle_level, RGB_IDLE_ACTIVE);
+
+    harness_idle(RGB_IDLE_DIM_TIMEOUT);
+    CHECK_EQ(rgb_idle_level, RGB_IDLE_DIM);
+    CHECK_EQ(rgb_matrix_get_val(), val >> RGB_IDLE_DIM_SHIFT);
+    CHECK_EQ(frames_over(1600), 1600 / 64);
+    CHECK_EQ(dark, 0);
+
+    // Ten minutes timed out: longer than the 16-bit frame timer wraps.
+    // QMK renders black frames; they are only flushed once a second.
+    harness_idle(RGB_MATRIX_TIMEOUT);
+    CHECK_EQ(rgb_idle_level, RGB_IDLE_OFF);
+    CHECK(rgb_matrix_is_enabled());
+    CHECK_EQ(frames_over(600000), 600000 / 1000);
+    CHECK_EQ(dark, 600000 / 1000);
+
+    key_tap(KC_A);
+    CHECK_EQ(rgb_idle_level, RGB_IDLE_ACTIVE);
+    CHECK_EQ(rgb_matrix_get_val(), val);
+    CHECK_EQ(frames_over(1600), 1600 / 16);
+    CHECK_EQ(dark, 0);
+}
+
+static void test_wake_latency(void) {
+    harness_test("rgb idle wake-up");
+    harness_idle(RGB_MATRIX_TIMEOUT + 1000);
+    CHECK_EQ(rgb_idle_level, RGB_IDLE_OFF);
+
+    // The press is reported in its own scan, the frame rate is restored
+    // after it, from housekeeping, and the next scan renders a lit frame
+    harness_reports_clear();
+    uint32_t pressed = harness_scans;
+    key_press(KC_A);
+    CHECK_EQ(harness_count_reports(REPORT_KEYBOARD), 1);
+    CHECK_EQ(harness_last_report(REPORT_KEYBOARD)->scan, pressed);
+    CHECK(keyboard_report_is(&harness_last_report(REPORT_KEYBOARD)->keyboard, KC_A));
+    CHECK_EQ(rgb_idle_level, RGB_IDLE_ACTIVE);
+    uint16_t lit = harness_rgb_frames - harness_rgb_dark_frames;
+    key_release(KC_A);
+    CHECK_EQ(harness_last_report(REPORT_KEYBOARD)->scan, pressed + 1);
+    CHECK_EQ(harness_rgb_frames - harness_rgb_dark_frames, lit + 1);
+}
+
+static void test_user_disabled(void) {
+    harness_test("rgb idle keeps user off");
+    rgb_matrix_disable_noeeprom();
+    harness_idle(RGB_MATRIX_TIMEOUT + 1000);
+    key_tap(KC_A);
+    CHECK(!rgb_matrix_is_enabled());
+    CHECK_EQ(frames_over(1600), 1600 / 16);
+    CHECK_EQ(dark, 1600 / 16);
+    rgb_matrix_enable_noeeprom();
+}
+
+int main(void) {
+    harness_boot(OS_MACOS);
+    test_levels();
+    test_wake_latency();
+    test_user_disabled();
+    return harness_done("test_rgb_idle");
+}
+
+#else
+
+int main(void) {
+    printf("test_rgb_idle: skipped, RGB_IDLE_ENABLE or RGB_MATRIX_ENABLE is off\n");
+    return 0;
+}
+
+#endif
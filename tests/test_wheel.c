@@ -0,0 +1,161 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+// The wheel report stream for each entry of wheel_curves: the first detent
+// on press, acceleration up to the curve's speed limit, the inertial tail
+// after release, and reversing direction while the wheel is moving.
+
+#include <stdio.h>
+
+#include "keymap.c"
+#include "keymap_introspection.c"
+
+#include "harness.h"
+
+#ifdef KINETIC_WHEEL_ENABLE
+
+static const os_variant_t all_os[] = { OS_UNSURE, OS_LINUX, OS_WINDOWS, OS_MACOS, OS_IOS };
+
+// Detection never reports OS_UNSURE over a known OS, so that column is what
+// a fresh board sends before detection completes
+static void use_os(os_variant_t os) {
+    harness_set_os(os);
+    if (os == OS_UNSURE) {
+        current_os = OS_UNSURE;
+    }
+}
+
+// Sign of the v detents MW_UP sends on os
+static int8_t up_sign(os_variant_t os) {
+    #ifdef OS_WHEEL_ENABLE
+    return (os == OS_MACOS || os == OS_IOS) ? 1 : -1;
+    #else
+    return 1;
+    #endif
+}
+
+typedef struct {
+    uint16_t detents;  // in the expected direction
+    uint16_t wrong;    // in the other direction, or on the h axis
+    uint32_t first;    // scan of the first detent, UINT32_MAX without one
+    uint32_t last;     // scan of the last detent
+} wheel_stream_t;
+
+// Wheel detents the host got in scans [from, to)
+static wheel_stream_t wheel_stream(uint32_t from, uint32_t to, int8_t sign) {
+    wheel_stream_t stream = { .first = UINT32_MAX };
+    for (uint16_t i = 0; i < harness_report_count; i++) {
+        const harness_report_t *r = &harness_reports[i];
+        if (r->type != REPORT_MOUSE || r->scan < from || r->scan >= to || (!r->mouse.v && !r->mouse.h)) {
+            continue;
+        }
+        if (r->mouse.h || r->mouse.v * sign < 0) {
+            stream.wrong++;
+            continue;
+        }
+        stream.detents += r->mouse.v * sign;
+        if (stream.first == UINT32_MAX) {
+            stream.first = r->scan;
+        }
+        stream.last = r->scan;
+    }
+    return stream;
+}
+
+// Scan of the next press or release
+#define NOW harness_scans
+
+static void test_curve(os_variant_t os) {
+    wheel_curve_t curve;
+    wheel_curve_for(os, &curve);
+    int8_t up = up_sign(os);
+
+    use_os(os);
+    key_press(MO(_LEFT_UP));
+    harness_reports_clear();
+
+    // Step: one detent on the next wheel tick
+    harness_test("wheel step");
+    uint32_t pressed = NOW;
+    key_press(MW_UP);
+    harness_idle(WHEEL_TICK_MS);
+    wheel_stream_t step = wheel_stream(pressed, NOW, up);
+    CHECK_EQ(step.detents, 1);
+    CHECK_EQ(step.wrong, 0);
+    CHECK(step.first <= pressed + WHEEL_TICK_MS);
+
+    // Acceleration: the first quarter second is slower than one at full
+    // speed, and full speed is curve.max/256 detents per tick
+    harness_test("wheel acceleration");
+    uint32_t ramp_end = pressed + 250;
+    uint32_t ramp_ms  = (uint32_t)(curve.max - curve.start) / curve.accel * WHEEL_TICK_MS;
+    harness_idle(ramp_end + ramp_ms + 250 - NOW);
+    harness_idle(250);
+    CHECK(wheel_stream(pressed, ramp_end, up).detents < wheel_stream(NOW - 250, NOW, up).detents);
+
+    harness_idle(256 * WHEEL_TICK_MS);
+    wheel_stream_t full = wheel_stream(NOW - 256 * WHEEL_TICK_MS, NOW, up);
+    CHECK(full.detents >= curve.max - 1 && full.detents <= curve.max + 1);
+    CHECK_EQ(wheel_stream(pressed, NOW, up).wrong, 0);
+
+    // Inertial tail: a bounded number of detents in the same direction, at
+    // most the sum of the decaying speeds, then silence
+    harness_test("wheel tail");
+    uint32_t released = NOW;
+    key_release(MW_UP);
+    harness_idle(5000);
+    wheel_stream_t tail  = wheel_stream(released, NOW, up);
+    uint16_t       bound = ((uint32_t)curve.max << curve.decay) / 256 + 1;
+    CHECK_EQ(tail.wrong, 0);
+    CHECK(tail.detents <= bound);
+    CHECK(tail.detents == 0 || tail.last < released + 1000);
+    CHECK(!wheel_active);
+    CHECK_EQ(wheel_axes[WHEEL_AXIS_V].speed, 0);
+
+    // Zero crossing: pressing the other direction at full speed stops the
+    // old one at once, releasing the old key does not stop the new one, and
+    // the tail keeps the new direction
+    harness_test("wheel reverse");
+    harness_reports_clear();
+    key_press(MW_UP);
+    harness_idle(ramp_ms + 500);
+    uint32_t reversed = NOW;
+    key_press(MW_DOWN);
+    harness_idle(WHEEL_TICK_MS);
+    wheel_stream_t turn = wheel_stream(reversed, NOW, -up);
+    CHECK_EQ(turn.wrong, 0);
+    CHECK_EQ(turn.detents, 1);
+
+    key_release(MW_UP);
+    harness_idle(500);
+    CHECK(wheel_stream(NOW - 250, NOW, -up).detents > 0);
+
+    released = NOW;
+    key_release(MW_DOWN);
+    harness_idle(5000);
+    CHECK_EQ(wheel_stream(reversed, NOW, -up).wrong, 0);
+    CHECK(wheel_stream(released, NOW, -up).detents <= bound);
+    CHECK(!wheel_active);
+
+    key_release(MO(_LEFT_UP));
+    CHECK_EQ(layer_state, 0);
+}
+
+int main(void) {
+    harness_boot(OS_MACOS);
+    for (uint8_t o = 0; o < ARRAY_SIZE(all_os); o++) {
+        test_curve(all_os[o]);
+    }
+
+    harness_test("pipeline");
+    CHECK_EQ(harness_report_dropped, 0);
+    return harness_done("test_wheel");
+}
+
+#else
+
+int main(void) {
+    printf("test_wheel: skipped, KINETIC_WHEEL_ENABLE is off\n");
+    return 0;
+}
+
+#endif
@@ -0,0 +1,83 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: GPL-2.0-or-later
+"""Format the binary event log written to the QMK console.
+
+Usage:
+    qmk console | python3 tools/event_log.py
+    python3 tools/event_log.py [--keymap keymap.c] console.log
+
+The firmware writes each record as one hex line:
+    E<id:2><time_ms:4><a:4><b:4>
+Event ids and format strings come from the LOG_EVENTS table in keymap.c, so
+the two never drift apart. Other console lines are passed through unchanged.
+"""
+
+import argparse
+import fileinput
+import os
+import re
+import string
+
+RECORD = re.compile(r"(?:^|\s)E([0-9a-f]{2})([0-9a-f]{4})([0-9a-f]{4})([0-9a-f]{4})\s*$")
+EVENT = re.compile(r'X\((\w+),\s*"((?:[^"\\]|\\.)*)"\)')
+OS_NAMES = ["unsure", "linux", "windows", "macos", "ios"]
+DEFAULT_KEYMAP = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "keymap.c")
+
+
+class EventFormatter(string.Formatter):
+    def convert_field(self, value, conversion):
+        if conversion == "o":
+            return OS_NAMES[value] if value < len(OS_NAMES) else str(value)
+        return super().convert_field(value, conversion)
+
+
+def load_events(path):
+    """Return [(name, format)] indexed by event id."""
+    with open(path) as source:
+        text = source.read()
+    start = text.find("#define LOG_EVENTS(X)")
+    if start < 0:
+        raise SystemExit(f"no LOG_EVENTS table in {path}")
+    # The table ends at the first line without a continuation backslash
+    lines = []
+    for line in text[start:].splitlines():
+        lines.append(line)
+        if not line.rstrip().endswith("\\"):
+            break
+    return EVENT.findall("\n".join(lines))
+
+
+def decode(line, events, formatter):
+    match = RECORD.search(line)
+    if not match:
+        return line
+    event_id, time_ms, a, b = (int(field, 16) for field in match.groups())
+    if event_id >= len(events):
+        return f"{line}  (unknown event {event_id})"
+    name, fmt = events[event_id]
+    fields = {
+        "a": a,
+        "b": b,
+        "a_hi": a >> 8,
+        "a_lo": a & 0xFF,
+        "b_hi": b >> 8,
+        "b_lo": b & 0xFF,
+    }
+    text = formatter.format(fmt, **fields)
+    return f"{line[:match.start()]}{time_ms:5d} {name}: {text}"
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--keymap", default=DEFAULT_KEYMAP, help="keymap.c holding LOG_EVENTS")
+    parser.add_argument("files", nargs="*", help="console logs (default: stdin)")
+    args = parser.parse_args()
+
+    events = load_events(args.keymap)
+    formatter = EventFormatter()
+    for line in fileinput.input(args.files):
+        print(decode(line.rstrip("\n"), events, formatter), flush=True)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,133 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: GPL-2.0-or-later
+"""Build the firmware per feature switch and report flash/RAM sizes.
+
+Usage:
+    python3 tools/footprint.py [--keymap zerodice0] [--qmk-home ~/qmk_firmware]
+    python3 tools/footprint.py --only OS_ACTIONS_ENABLE,RGB_OS_INDICATOR_ENABLE
+    python3 tools/footprint.py --combo OS_CHORD_ENABLE,EVENT_LOG_ENABLE
+    python3 tools/footprint.py --host
+
+Builds the keymap as configured in rules.mk, then once with each keymap
+feature (the "# Keymap features" block of rules.mk) that is on turned off
+and each one that is off turned on, then with all of them off, and prints
+.text/.data/.bss of each build and the change from the default build.
+Features are switched with `qmk compile -e NAME=no`, so rules.mk itself is
+left untouched. Requires the QMK CLI and
+avr-size on PATH.
+
+With --host, only keymap.c is built, with the host compiler against the
+QMK stand-in of the tests (`make -C tests size`). The sizes are host code
+and leave out QMK itself, so they only rank features against each other;
+they say nothing about whether the firmware fits the AVR flash.
+"""
+
+import argparse
+import os
+import re
+import subprocess
+
+KEYBOARD = "keebio/iris/rev7"
+ROOT = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..")
+RULES = os.path.join(ROOT, "rules.mk")
+TESTS = os.path.join(ROOT, "tests")
+FEATURE = re.compile(r"^(\w+_ENABLE)\s*=\s*(yes|no)\b")
+
+
+def keymap_features(path):
+    """Feature switches of the "# Keymap features" block of rules.mk, as
+    (switches that are on, switches that are off)."""
+    features = {"yes": [], "no": []}
+    in_block = False
+    with open(path) as rules:
+        for line in rules:
+            if line.startswith("# Keymap features"):
+                in_block = True
+            elif in_block:
+                match = FEATURE.match(line)
+                if match:
+                    features[match.group(2)].append(match.group(1))
+                elif line.strip() and not line.startswith("#"):
+                    break
+    return features["yes"], features["no"]
+
+
+def qmk_home(override):
+    if override:
+        return os.path.expanduser(override)
+    try:
+        out = subprocess.run(["qmk", "config", "user.qmk_home"], capture_output=True, text=True, check=True).stdout
+        return out.strip().split("=", 1)[1]
+    except (OSError, subprocess.CalledProcessError, IndexError):
+        return os.path.expanduser("~/qmk_firmware")
+
+
+def build(home, keymap, switches):
+    """Compile with the given NAME=yes/no switches; returns (text, data, bss) or None."""
+    command = ["qmk", "compile", "-kb", KEYBOARD, "-km", keymap]
+    for switch in switches:
+        command += ["-e", switch]
+    if subprocess.run(command, cwd=home, capture_output=True).returncode != 0:
+        return None
+
+    elf = os.path.join(home, ".build", f"{KEYBOARD.replace('/', '_')}_{keymap}.elf")
+    out = subprocess.run(["avr-size", "--format=berkeley", elf], capture_output=True, text=True, check=True).stdout
+    text, data, bss = out.splitlines()[1].split()[:3]
+    return int(text), int(data), int(bss)
+
+
+def build_host(switches):
+    """Compile keymap.c for the host with the given NAME=yes/no switches."""
+    command = ["make", "-s", "-C", TESTS, "BUILD=build/footprint", "size"] + switches
+    result = subprocess.run(command, capture_output=True, text=True)
+    if result.returncode != 0:
+        return None
+
+    text, data, bss = result.stdout.splitlines()[-1].split()[:3]
+    return int(text), int(data), int(bss)
+
+
+def row(label, sizes, base):
+    if sizes is None:
+        return f"{label:<32} build failed"
+    text, data, bss = sizes
+    line = f"{label:<32} {text:>7} {data:>6} {bss:>6}   flash {text + data:>6}  ram {data + bss:>5}"
+    if base and sizes != base:
+        flash = (text + data) - (base[0] + base[1])
+        ram = (data + bss) - (base[1] + base[2])
+        line += f"   ({flash:+d} flash, {ram:+d} ram)"
+    return line
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--keymap", default="zerodice0", help="keymap directory name")
+    parser.add_argument("--qmk-home", help="qmk_firmware checkout (default: qmk config user.qmk_home)")
+    parser.add_argument("--only", help="comma-separated features to measure instead of all")
+    parser.add_argument("--combo", action="append", default=[], help="also build with these comma-separated features off")
+    parser.add_argument("--host", action="store_true", help="size keymap.c built for the host instead of the firmware")
+    args = parser.parse_args()
+
+    home = None if args.host else qmk_home(args.qmk_home)
+    features, off = keymap_features(RULES)
+    if args.only:
+        only = args.only.split(",")
+        features = [name for name in only if name not in off]
+        off = [name for name in only if name in off]
+    builds = [("default", [])]
+    builds += [(f"-{name}", [f"{name}=no"]) for name in features]
+    builds += [(f"+{name}", [f"{name}=yes"]) for name in off]
+    builds += [(f"-{combo}", [f"{name}=no" for name in combo.split(",")]) for combo in args.combo]
+    builds.append(("all keymap features off", [f"{name}=no" for name in features]))
+
+    print(f"{'build':<32} {'.text':>7} {'.data':>6} {'.bss':>6}")
+    base = None
+    for label, switches in builds:
+        sizes = build_host(switches) if args.host else build(home, args.keymap, switches)
+        if base is None:
+            base = sizes
+        print(row(label, sizes, base), flush=True)
+
+
+if __name__ == "__main__":
+    main()
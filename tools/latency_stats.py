@@ -0,0 +1,60 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: GPL-2.0-or-later
+"""Decode the LAT_DUMP latency histogram printed on the QMK console.
+
+Usage:
+    qmk console | python3 tools/latency_stats.py
+    python3 tools/latency_stats.py console.log
+
+Each dump line looks like:
+    LAT <ticks_per_ms> <ticks_per_bucket> <max_ticks> <count0> ... <countN>
+
+The last bucket also holds every sample above the histogram range.
+"""
+
+import fileinput
+import re
+
+LINE = re.compile(r"LAT((?: \d+)+)")
+
+
+def percentile(buckets, bucket_us, fraction):
+    total = sum(buckets)
+    if total == 0:
+        return 0.0
+    target = total * fraction
+    seen = 0
+    for index, count in enumerate(buckets):
+        seen += count
+        if seen >= target:
+            # Report the upper edge of the bucket the sample falls into
+            return (index + 1) * bucket_us
+    return len(buckets) * bucket_us
+
+
+def report(fields):
+    ticks_per_ms, ticks_per_bucket, max_ticks = fields[:3]
+    buckets = fields[3:]
+    tick_us = 1000.0 / ticks_per_ms
+    bucket_us = ticks_per_bucket * tick_us
+
+    print(f"samples: {sum(buckets)}")
+    print(f"p50:     <= {percentile(buckets, bucket_us, 0.50):.0f} us")
+    print(f"p99:     <= {percentile(buckets, bucket_us, 0.99):.0f} us")
+    print(f"max:     {max_ticks * tick_us:.0f} us")
+    for index, count in enumerate(buckets):
+        low = index * bucket_us
+        edge = "+" if index == len(buckets) - 1 else f"-{low + bucket_us:.0f}"
+        print(f"  {low:6.0f}{edge:>7} us  {count}")
+    print()
+
+
+def main():
+    for line in fileinput.input():
+        match = LINE.search(line)
+        if match:
+            report([int(field) for field in match.group(1).split()])
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,159 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: GPL-2.0-or-later
+"""Read and edit the OS action mappings (SC_*, LANG_SW, MW_*) over raw HID.
+
+Usage:
+    python3 tools/os_action_map.py list
+    python3 tools/os_action_map.py set LANG_SW linux "S(KC_SPC)"
+    python3 tools/os_action_map.py set SC_AREA windows 0x0846
+    python3 tools/os_action_map.py clear LANG_SW linux
+    python3 tools/os_action_map.py reset
+
+Changes apply immediately; the keyboard saves them to EEPROM a couple of
+seconds after the last change. Keycodes are numbers or QMK-style
+expressions such as "C(S(KC_PSCR))" or "LGUI(KC_SPC)"; the keyboard accepts
+a basic keycode with modifiers or a wheel direction (MS_WHLU, MS_WHLD,
+MS_WHLL, MS_WHLR). Requires the hidapi Python package (pip install hid).
+"""
+
+import argparse
+import re
+import string
+
+import hid
+
+VENDOR_ID = 0xCB10  # Keebio
+RAW_USAGE_PAGE = 0xFF60
+RAW_USAGE = 0x61
+REPORT_SIZE = 32
+
+RAW_HID_OS_ACTION_GET = 0x02
+RAW_HID_OS_ACTION_SET = 0x03
+RAW_HID_OS_ACTION_RESET = 0x04
+RAW_HID_UNHANDLED = 0xFF
+
+# Same order as OS_ACTIONS and os_variant_t in keymap.c
+ACTIONS = ["SC_FULL", "SC_AREA", "SC_MENU", "SC_CLIP_FULL", "SC_CLIP_AREA",
+           "LANG_SW", "MW_RIGHT", "MW_UP", "MW_DOWN", "MW_LEFT"]
+OSES = ["unsure", "linux", "windows", "macos", "ios"]
+STATUS = ["ok", "invalid action, OS or keycode", "override table full"]
+
+MODS = {"LCTL": 0x0100, "LSFT": 0x0200, "LALT": 0x0400, "LGUI": 0x0800,
+        "RCTL": 0x1100, "RSFT": 0x1200, "RALT": 0x1400, "RGUI": 0x1800}
+MODS.update({"C": MODS["LCTL"], "S": MODS["LSFT"], "A": MODS["LALT"], "G": MODS["LGUI"]})
+
+KEYCODES = {f"KC_{letter}": 0x04 + index for index, letter in enumerate(string.ascii_uppercase)}
+KEYCODES.update({f"KC_{digit}": 0x1E + index for index, digit in enumerate("1234567890")})
+KEYCODES.update({f"KC_F{number}": 0x3A + number - 1 for number in range(1, 13)})
+KEYCODES.update({
+    "KC_NO": 0x00, "KC_ENT": 0x28, "KC_ESC": 0x29, "KC_BSPC": 0x2A, "KC_TAB": 0x2B,
+    "KC_SPC": 0x2C, "KC_MINS": 0x2D, "KC_EQL": 0x2E, "KC_LBRC": 0x2F, "KC_RBRC": 0x30,
+    "KC_BSLS": 0x31, "KC_SCLN": 0x33, "KC_QUOT": 0x34, "KC_GRV": 0x35, "KC_COMM": 0x36,
+    "KC_DOT": 0x37, "KC_SLSH": 0x38, "KC_CAPS": 0x39, "KC_PSCR": 0x46, "KC_HOME": 0x4A,
+    "KC_PGUP": 0x4B, "KC_DEL": 0x4C, "KC_END": 0x4D, "KC_PGDN": 0x4E, "KC_RGHT": 0x4F,
+    "KC_LEFT": 0x50, "KC_DOWN": 0x51, "KC_UP": 0x52, "KC_LNG1": 0x90, "KC_LNG2": 0x91,
+    "KC_LCTL": 0xE0, "KC_LSFT": 0xE1, "KC_LALT": 0xE2, "KC_LGUI": 0xE3,
+    "KC_RCTL": 0xE4, "KC_RSFT": 0xE5, "KC_RALT": 0xE6, "KC_RGUI": 0xE7,
+    "MS_WHLU": 0xD9, "MS_WHLD": 0xDA, "MS_WHLL": 0xDB, "MS_WHLR": 0xDC,
+})
+NAMES = {value: name for name, value in KEYCODES.items()}
+
+
+def parse_keycode(text):
+    text = text.strip()
+    if re.fullmatch(r"(0x[0-9a-fA-F]+|\d+)", text):
+        return int(text, 0)
+    match = re.fullmatch(r"(\w+)\((.*)\)", text)
+    if match and match.group(1) in MODS:
+        return MODS[match.group(1)] | parse_keycode(match.group(2))
+    if text in KEYCODES:
+        return KEYCODES[text]
+    raise SystemExit(f"unknown keycode: {text}")
+
+
+def format_keycode(keycode):
+    if keycode > 0x1FFF:
+        return f"0x{keycode:04X}"
+    name = NAMES.get(keycode & 0xFF, f"0x{keycode & 0xFF:02X}")
+    mods = keycode & 0x1F00
+    for wrapper, bits in (("LCTL", 0x0100), ("LSFT", 0x0200), ("LALT", 0x0400), ("LGUI", 0x0800)):
+        if mods & bits:
+            right = "R" if mods & 0x1000 else "L"
+            name = f"{right}{wrapper[1:]}({name})"
+    return name
+
+
+def open_keyboard():
+    for info in hid.enumerate(VENDOR_ID):
+        if info["usage_page"] == RAW_USAGE_PAGE and info["usage"] == RAW_USAGE:
+            device = hid.device()
+            device.open_path(info["path"])
+            return device
+    raise SystemExit("keyboard raw HID interface not found")
+
+
+def request(device, payload):
+    # Leading 0 is the report ID expected by hidapi
+    device.write([0] + payload + [0] * (REPORT_SIZE - len(payload)))
+    reply = device.read(REPORT_SIZE, 1000)
+    if not reply or reply[0] == RAW_HID_UNHANDLED:
+        raise SystemExit("firmware does not support OS action remapping")
+    return reply
+
+
+def lookup(names, value, kind):
+    try:
+        return names.index(value)
+    except ValueError:
+        raise SystemExit(f"unknown {kind} {value}; choose from {', '.join(names)}")
+
+
+def command_list(device, _args):
+    print(f"{'action':<14}" + "".join(f"{os:<18}" for os in OSES))
+    for index, action in enumerate(ACTIONS):
+        reply = request(device, [RAW_HID_OS_ACTION_GET, index])
+        if reply[2] != 0:
+            break
+        keycodes = [reply[5 + os * 2] | reply[6 + os * 2] << 8 for os in range(reply[4])]
+        print(f"{action:<14}" + "".join(f"{format_keycode(keycode):<18}" for keycode in keycodes))
+
+
+def set_mapping(device, action, os, keycode):
+    reply = request(device, [RAW_HID_OS_ACTION_SET, action, os, keycode & 0xFF, keycode >> 8])
+    if reply[3] != 0:
+        raise SystemExit(STATUS[reply[3]] if reply[3] < len(STATUS) else f"error {reply[3]}")
+
+
+def command_set(device, args):
+    set_mapping(device, lookup(ACTIONS, args.action, "action"), lookup(OSES, args.os, "OS"), parse_keycode(args.keycode))
+
+
+def command_clear(device, args):
+    set_mapping(device, lookup(ACTIONS, args.action, "action"), lookup(OSES, args.os, "OS"), 0)
+
+
+def command_reset(device, _args):
+    request(device, [RAW_HID_OS_ACTION_RESET])
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    commands = parser.add_subparsers(dest="command", required=True)
+    commands.add_parser("list", help="show the mapping of every action").set_defaults(run=command_list)
+    set_parser = commands.add_parser("set", help="override an action on one OS")
+    set_parser.add_argument("action")
+    set_parser.add_argument("os")
+    set_parser.add_argument("keycode")
+    set_parser.set_defaults(run=command_set)
+    clear_parser = commands.add_parser("clear", help="restore the default of an action on one OS")
+    clear_parser.add_argument("action")
+    clear_parser.add_argument("os")
+    clear_parser.set_defaults(run=command_clear)
+    commands.add_parser("reset", help="restore every default").set_defaults(run=command_reset)
+
+    args = parser.parse_args()
+    args.run(open_keyboard(), args)
+
+
+if __name__ == "__main__":
+    main()
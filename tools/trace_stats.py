@@ -0,0 +1,129 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: GPL-2.0-or-later
+"""Collect the key event trace over raw HID and print typing statistics.
+
+Usage:
+    python3 tools/trace_stats.py [--seconds N] [--dump trace.csv]
+
+Requires the hidapi Python package (pip install hid). The keyboard answers
+RAW_HID_TRACE_READ (0x01) with:
+    [0x01, count, dropped_lo, dropped_hi, event * count]
+where each 4-byte event is <time_ms:u16le, pos:u8, layer:u8> and
+pos = row << 4 | pressed << 3 | col.
+"""
+
+import argparse
+import statistics
+import struct
+import time
+from collections import Counter
+
+import hid
+
+VENDOR_ID = 0xCB10  # Keebio
+RAW_USAGE_PAGE = 0xFF60
+RAW_USAGE = 0x61
+REPORT_SIZE = 32
+
+RAW_HID_TRACE_READ = 0x01
+LAYER_NAMES = ["BASIC", "LEFT_UNDER", "RIGHT_UNDER", "BOTH_UNDER", "LEFT_UP"]
+
+
+def open_keyboard():
+    for info in hid.enumerate(VENDOR_ID):
+        if info["usage_page"] == RAW_USAGE_PAGE and info["usage"] == RAW_USAGE:
+            device = hid.device()
+            device.open_path(info["path"])
+            return device
+    raise SystemExit("keyboard raw HID interface not found")
+
+
+def read_events(device):
+    """Drain the firmware buffer; returns (events, dropped)."""
+    events = []
+    dropped = 0
+    while True:
+        # Leading 0 is the report ID expected by hidapi
+        device.write([0, RAW_HID_TRACE_READ] + [0] * (REPORT_SIZE - 1))
+        reply = device.read(REPORT_SIZE, 1000)
+        if not reply or reply[0] != RAW_HID_TRACE_READ:
+            raise SystemExit("firmware does not support trace reads")
+        count = reply[1]
+        dropped += reply[2] | reply[3] << 8
+        for index in range(count):
+            offset = 4 + index * 4
+            ms, pos, layer = struct.unpack_from("<HBB", bytes(reply), offset)
+            events.append((ms, pos >> 4, pos & 7, bool(pos & 8), layer))
+        if count == 0:
+            return events, dropped
+
+
+def unwrap_times(events):
+    """Turn 16-bit millisecond stamps into a monotonic timeline."""
+    timeline = []
+    base = 0
+    previous = None
+    for ms, row, col, pressed, layer in events:
+        if previous is not None and ms < previous:
+            base += 1 << 16
+        previous = ms
+        timeline.append((base + ms, row, col, pressed, layer))
+    return timeline
+
+
+def report(events, dropped):
+    presses = [event for event in events if event[3]]
+    print(f"events: {len(events)}  presses: {len(presses)}  dropped: {dropped}")
+
+    intervals = [b[0] - a[0] for a, b in zip(presses, presses[1:])]
+    # Gaps over two seconds are pauses, not typing
+    intervals = [interval for interval in intervals if interval < 2000]
+    if intervals:
+        quantiles = statistics.quantiles(intervals, n=100)
+        print("inter-key interval (ms):")
+        print(f"  mean {statistics.mean(intervals):.1f}  p50 {quantiles[49]:.0f}  p90 {quantiles[89]:.0f}  p99 {quantiles[98]:.0f}")
+
+    holds = {}
+    durations = []
+    for ms, row, col, pressed, _ in events:
+        if pressed:
+            holds[(row, col)] = ms
+        elif (row, col) in holds:
+            durations.append(ms - holds.pop((row, col)))
+    if durations:
+        print(f"hold time (ms): mean {statistics.mean(durations):.1f}  max {max(durations)}")
+
+    layers = Counter(event[4] for event in presses)
+    print("layer usage (presses):")
+    for layer, count in sorted(layers.items()):
+        name = LAYER_NAMES[layer] if layer < len(LAYER_NAMES) else str(layer)
+        print(f"  {name:<12} {count:6d}  {100.0 * count / len(presses):5.1f}%")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--seconds", type=float, default=60, help="how long to record")
+    parser.add_argument("--dump", help="also write the raw events to this CSV file")
+    args = parser.parse_args()
+
+    device = open_keyboard()
+    events = []
+    dropped = 0
+    deadline = time.monotonic() + args.seconds
+    while time.monotonic() < deadline:
+        batch, lost = read_events(device)
+        events.extend(batch)
+        dropped += lost
+        time.sleep(0.05)
+
+    events = unwrap_times(events)
+    if args.dump:
+        with open(args.dump, "w") as csv:
+            csv.write("time_ms,row,col,pressed,layer\n")
+            for event in events:
+                csv.write(",".join(str(int(field)) for field in event) + "\n")
+    report(events, dropped)
+
+
+if __name__ == "__main__":
+    main()